@@ -11,6 +11,23 @@
 
 
 
+//	ES 3.0 doesn't have glMapBuffer(), so it doesn't define the access policies mapPBO() takes- these have 
+//	the same values as the desktop (and ES 3.1) definitions, and are translated to glMapBufferRange() bits.
+#if defined(VVGL_TARGETENV_GLES3)
+	#ifndef GL_READ_ONLY
+		#define GL_READ_ONLY 0x88B8
+	#endif
+	#ifndef GL_WRITE_ONLY
+		#define GL_WRITE_ONLY 0x88B9
+	#endif
+	#ifndef GL_READ_WRITE
+		#define GL_READ_WRITE 0x88BA
+	#endif
+#endif
+
+
+
+
 namespace VVGL	{
 
 
@@ -247,10 +264,10 @@ class VVGL_EXPORT GLBuffer	{
 		bool safeToPublishToSyphon() const;
 #endif
 		
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#if !defined(VVGL_TARGETENV_GLES)
 		/*!
 		\brief Maps the PBO if the receiver is a PBO-type GLBuffer, does nothing if it's not a PBO-type GLBuffer.
-		\param inAccess The access policy OpenGL will use when mapping the PBO.  GL_READ_ONLY, GL_WRITE_ONLY, or GL_READ_WRITE.
+		\param inAccess The access policy OpenGL will use when mapping the PBO.  GL_READ_ONLY, GL_WRITE_ONLY, or GL_READ_WRITE.  On ES3 the whole buffer is mapped with glMapBufferRange() instead.
 		\param inUseCurrentContext If true, the current GL context for this thread will be used to perform the GL operation.  Defaults to false (by default, it will make its buffer pool's context current before doing the GL op).
 		*/
 		void mapPBO(const uint32_t & inAccess, const bool & inUseCurrentContext=false);
@@ -259,7 +276,7 @@ class VVGL_EXPORT GLBuffer	{
 		\param inUseCurrentContext If true, the current GL context for this thread will be used to perform the GL operation.  Defaults to false (by default, it will make its buffer pool's context current before doing the GL op).
 		*/
 		void unmapPBO(const bool & inUseCurrentContext=false);
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 		//!	Returns a true if the receiver's timestamp is a match to the passed GLBuffer's timestamp (assumes that timestamps can be used to uniquely identify the content of a GLBuffer instance).
 		bool isContentMatch(GLBuffer & n) const;
 		//void draw(const Rect & dst) const;
@@ -3,7 +3,12 @@
 
 #include "VVGL_Defines.hpp"
 
+#include <memory>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <future>
 
 #include "GLBuffer.hpp"
 
@@ -30,6 +35,66 @@ namespace VVGL	{
 
 
 
+//! Allocates the CPU memory that backs the CPU buffers and CPU-backed textures created by GLBufferPool.
+/*!
+\ingroup VVGL_BASIC
+
+Subclass this and pass an instance to GLBufferPool::setCPUBackingAllocator() to control how CPU backings are allocated.  Every buffer retains the allocator that allocated its backing, so a pool's allocator can be replaced at any time.  Allocators may be used from any thread.
+*/
+class VVGL_EXPORT GLCPUBackingAllocator	{
+	public:
+		virtual ~GLCPUBackingAllocator() {}
+		//!	Returns a block of memory that's at least 'n' bytes long, or null if it couldn't be allocated.
+		virtual void * allocate(const size_t & n) = 0;
+		//!	Releases a block of memory that was returned by allocate().  'n' is the length that was passed to allocate().
+		virtual void release(void * inPtr, const size_t & n) = 0;
+		//!	Frees any memory the allocator is holding on to for re-use.  Called by GLBufferPool::purge().
+		virtual void purge() {}
+};
+
+
+
+
+//! The default GLCPUBackingAllocator: allocates aligned blocks of memory, and recycles them.
+/*!
+\ingroup VVGL_BASIC
+
+Notes on use:
+- Blocks are at least 64-byte aligned (SIMD loads/stores), and blocks that are a page or larger are page-aligned (pinned/DMA transfers).
+- Lengths are rounded up to a size class (there are four size classes per power of two, so at most 25% of a block is wasted)- released blocks are kept and handed out again for allocations in the same size class.
+- If huge pages are enabled, blocks that are 2MB or larger are 2MB-aligned and the OS is advised to back them with huge pages where that's supported (currently linux), which cuts down on page faults when streaming large frames.
+*/
+class VVGL_EXPORT GLPooledCPUBackingAllocator : public GLCPUBackingAllocator	{
+	private:
+		std::mutex			_lock;
+		std::unordered_map<size_t, std::vector<void*>>		_freeBlocks;	//	key is the size class of the blocks in the vector
+		size_t				_freeBytes = 0;
+		size_t				_maxFreeBytes = 0;
+		bool				_hugePages = true;
+	public:
+		/*!
+		\param inMaxFreeBytes Released blocks are freed instead of kept for re-use if the allocator is already keeping this many bytes.
+		\param inHugePages Whether or not large blocks should be backed by huge pages.
+		*/
+		GLPooledCPUBackingAllocator(const size_t & inMaxFreeBytes=(256*1024*1024), const bool & inHugePages=true);
+		virtual ~GLPooledCPUBackingAllocator();
+		
+		virtual void * allocate(const size_t & n);
+		virtual void release(void * inPtr, const size_t & n);
+		virtual void purge();
+		
+		//!	Returns the length of the blocks that are allocated for requests of the passed length.
+		static size_t sizeClassForLength(const size_t & n);
+		//!	Returns the number of bytes occupied by blocks that have been released, and are waiting to be re-used.
+		size_t freeBytes();
+	
+	private:
+		size_t alignmentForSizeClass(const size_t & n) const;
+};
+
+
+
+
 //! Buffer pools create and manage GL resources which, on deletion, are either destroyed or returned to the pool for re-use.
 /*!
 \ingroup VVGL_BASIC
@@ -41,17 +106,119 @@ Notes on use:
 - Don't forget to call the housekeeping() member function on your buffer pools periodically!
 - GLBufferPool requires a GL context on creation- the pool maintains a strong ref to this context, and will use it to create/destroy GL resources unless instructed otherwise via the "createInCurrentContext" variable in the various buffer creation functions.
 */
-class VVGL_EXPORT GLBufferPool	{
+class VVGL_EXPORT GLBufferPool : public std::enable_shared_from_this<GLBufferPool>	{
+	
+	public:
+		//!	A snapshot of the pool's counters, returned by stats().  The arrays are indexed by GLBuffer::Type.  VBOs, EBOs, and VAOs are never recycled and aren't counted.
+		struct Stats	{
+			//!	The number of times a request for a buffer was fulfilled by recycling a free buffer.
+			uint64_t		fetchHits[GLBuffer::Type_VAO+1];
+			//!	The number of times a request for a buffer couldn't be fulfilled by recycling a free buffer.
+			uint64_t		fetchMisses[GLBuffer::Type_VAO+1];
+			//!	The number of GL objects (textures, renderbuffers, FBOs, and PBOs) the pool created.
+			uint64_t		glObjectsCreated[GLBuffer::Type_VAO+1];
+			//!	The number of GL objects (textures, renderbuffers, FBOs, and PBOs) the pool deleted.
+			uint64_t		glObjectsDestroyed[GLBuffer::Type_VAO+1];
+			//!	The number of free buffers released by housekeeping() or to stay within the pool's byte budget.
+			uint64_t		evictions = 0;
+			//!	The number of bytes occupied by free buffers waiting to be recycled.
+			size_t			freeBytes = 0;
+			//!	The number of bytes occupied by buffers the pool vended which are still in use.
+			size_t			liveBytes = 0;
+			//!	The number of bytes occupied by resources the pool created which haven't been released yet (free and live).
+			size_t			residentBytes = 0;
+			//!	The highest value 'residentBytes' reached since the pool was created or resetStats() was called.
+			size_t			peakResidentBytes = 0;
+			
+			Stats();
+			//!	Returns the fraction of requests (of all types) that were fulfilled by recycling a free buffer, or 0 if there haven't been any.
+			double hitRate() const;
+		};
+	
+	//	free buffers are indexed by the properties that have to match for them to be recycled
+	protected:
+		struct FreeBufferKey	{
+			GLBuffer::Type				type;
+			GLBuffer::Target			target;
+			GLBuffer::InternalFormat	internalFormat;
+			GLBuffer::PixelFormat		pixelFormat;
+			GLBuffer::PixelType			pixelType;
+			GLBuffer::Backing			cpuBackingType;
+			GLBuffer::Backing			gpuBackingType;
+			bool						texRangeFlag;
+			bool						texClientStorageFlag;
+			uint32_t					msAmount;
+			Size						size;
+			
+			FreeBufferKey(const GLBuffer::Descriptor & inDesc, const Size & inSize);
+			bool operator==(const FreeBufferKey & n) const;
+		};
+		struct FreeBufferKeyHash	{
+			size_t operator()(const FreeBufferKey & n) const;
+		};
+		//	free buffers are owned by the pool directly- a new GLBufferRef is made for a buffer when it's recycled, and when the last ref to it is released the same GLBuffer instance is returned to the pool
+		struct FreeBuffer	{
+			std::unique_ptr<GLBuffer>		buffer;
+			uint64_t		returnIndex = 0;	//	the value of '_returnCount' when the buffer was returned- used to find the least-recently-used free buffer
+		};
+		//	GLBufferRefs vended by the pool use this deleter, which returns the GLBuffer to the pool (or deletes it if it can't be recycled)
+		struct RecyclingDeleter	{
+			void operator()(GLBuffer * n) const;
+		};
+		//	buffers released on a thread are held in a small per-thread cache, and moved to the shared free lists in batches when the cache fills up.  the cache's lock is only contended when housekeeping()/purge() visit it.
+		struct ThreadCache	{
+			std::mutex				lock;
+			std::vector<FreeBuffer>		buffers;	//	ordered from least- to most-recently returned
+			std::atomic<bool>		threadExited{false};	//	set when the cache's thread exits- the pool stops tracking the cache the next time it flushes it
+		};
+		//	buffers requested with createBufferRefAsync() are created by a worker thread that has its own GL context (in the pool's sharegroup).  defined in the .cpp.
+		struct AsyncWorker;
+		//	the counters behind stats()- these are incremented from any thread, so they're all atomic
+		struct StatCounters	{
+			std::atomic<uint64_t>		fetchHits[GLBuffer::Type_VAO+1];
+			std::atomic<uint64_t>		fetchMisses[GLBuffer::Type_VAO+1];
+			std::atomic<uint64_t>		glObjectsCreated[GLBuffer::Type_VAO+1];
+			std::atomic<uint64_t>		glObjectsDestroyed[GLBuffer::Type_VAO+1];
+			std::atomic<uint64_t>		evictions;
+			
+			StatCounters() { reset(); }
+			void reset();
+		};
+		//	the GL resources of released buffers are pushed onto a lock-free stack of these, and deleted in batches by housekeeping()
+		struct QueuedDeletion	{
+			GLBuffer::Type		type;
+			uint32_t			name;
+			QueuedDeletion		*next;
+		};
 	
 	//	vars
 	protected:
 		bool				_deleted = false;
 		std::mutex				_freeBuffersLock;
-		std::vector<GLBufferRef>		_freeBuffers;
+		//	each key maps to a list of free buffers ordered from least- to most-recently returned to the pool
+		std::unordered_map<FreeBufferKey, std::vector<FreeBuffer>, FreeBufferKeyHash>		_freeBuffers;
+		std::atomic<uint64_t>		_returnCount;	//	incremented every time a buffer is returned to the pool
+		
+		uint64_t			_poolID = 0;	//	unique to each pool- used by threads to look up their caches (a pool's address may be reused after it's freed)
+		std::mutex			_threadCachesLock;
+		std::unordered_map<std::thread::id, std::shared_ptr<ThreadCache>>		_threadCaches;	//	caches stay registered when they're flushed- they're only removed once their thread has exited, so they don't accumulate
+		
+		std::atomic<size_t>		_byteBudget;	//	if non-zero, free buffers are evicted (least-recently-used first) to keep '_residentBytes' under this value
+		std::atomic<size_t>		_residentBytes;	//	the number of bytes occupied by resources this pool created that haven't been released yet (free buffers and buffers in use)
+		std::atomic<size_t>		_peakResidentBytes;
+		std::atomic<size_t>		_freeBytes;	//	the number of bytes occupied by buffers in '_freeBuffers'
+		
+		StatCounters		_stats;
+		
+		std::atomic<QueuedDeletion*>		_deletionQueue;	//	GL resources waiting to be deleted by housekeeping().  any thread can push onto this without taking a lock.
+		
+		std::shared_ptr<AsyncWorker>		_asyncWorker = nullptr;	//	created the first time createBufferRefAsync() is called (access is protected by '_contextLock')
 		
 		std::recursive_mutex		_contextLock;
 		GLContextRef		_context = nullptr;	//	this is the context that the buffer pool will use to create/destroy GL resources
 		
+		GLCPUBackingAllocatorRef		_cpuBackingAllocator = nullptr;	//	allocates the memory for CPU-backed buffers.  only accessed with std::atomic_load()/std::atomic_store().
+		
 		Timestamp			_baseTime;
 		
 #if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_IOS)
@@ -68,12 +235,61 @@ class VVGL_EXPORT GLBufferPool	{
 		
 		//!	This member function is how the pool creates buffers.  You probably shouldn't call this function directly- instead use one of the functions in (\ref VVGL_BUFFERCREATE) directly or as a prototype.  They're in %GLBufferPool.hpp/GLBufferPool.cpp.
 		GLBufferRef createBufferRef(const GLBuffer::Descriptor & desc, const Size & size={640,480}, const void * backingPtr=nullptr, const Size & backingSize={640,480}, const bool & createInCurrentContext=false);
+		/*!
+		\brief Creates several buffers at once- free buffers are recycled where possible, and the rest are created with a single context switch, one glGen* call per type, and a single flush.  Like createBufferRef(), you probably want to use one of the array creation functions in (\ref VVGL_BUFFERCREATE) instead of calling this directly.
+		\param requests The descriptor and size of each buffer to create.  Buffers with CPU backings can't be created this way- use the buffer creation functions.
+		\param createInCurrentContext If true, the buffers are created in the current GL context instead of the pool's context.
+		\return A std::vector containing the buffers, in the same order as 'requests'.  A buffer is null if it couldn't be created.
+		*/
+		std::vector<GLBufferRef> createBufferRefs(const std::vector<std::pair<GLBuffer::Descriptor,Size>> & requests, const bool & createInCurrentContext=false);
 		GLBufferRef fetchMatchingFreeBuffer(const GLBuffer::Descriptor & desc, const Size & size);
+		/*!
+		\brief Creates a buffer on a worker thread, so the calling thread doesn't have to wait for its GL resources to be allocated.
+		\param desc The descriptor of the buffer to create.  Only buffers with GPU-side resources and no CPU backing (textures, renderbuffers, FBOs) can be created asynchronously- the future vends null for anything else.
+		\param size The size of the buffer to create.
+		\return A future that vends the buffer (or null if it couldn't be created).  The worker waits on a fence before fulfilling the future, so the buffer can be used by any context in the pool's sharegroup as soon as it's available.  If the pool has a matching free buffer, the future is ready immediately.
+		The worker thread's GL context is created (using the pool's context) the first time this is called, so under GLFW the first call must be made on the main thread.  Under Qt, GL contexts can't be used on threads other than the one that created them- buffers are created synchronously, and the future is always ready immediately.  The pool must be owned by a GLBufferPoolRef.
+		*/
+		std::shared_future<GLBufferRef> createBufferRefAsync(const GLBuffer::Descriptor & desc, const Size & size={640,480});
+		/*!
+		\brief Pre-allocates buffers so the pool can vend them later without creating GL resources mid-frame.
+		\param desc The descriptor of the buffers to create.  Only buffers with GPU-side resources and no CPU backing (textures, renderbuffers, FBOs) can be reserved- the pool returns 0 for anything else.
+		\param size The size of the buffers to create.
+		\param count The number of matching free buffers the pool should have when this function returns.  Matching free buffers that are already in the pool (including those cached by other threads) count towards this total, so calling this repeatedly with the same values doesn't create more buffers.
+		\param createInCurrentContext If true, the buffers are created in the current GL context instead of the pool's context.
+		\return The number of buffers created.
+		Reserved buffers are placed in the pool's shared free lists, so any thread can use them.  They're subject to the same housekeeping as any other free buffer- if they aren't used they'll eventually be released.  The pool must be owned by a GLBufferPoolRef.
+		*/
+		size_t reserve(const GLBuffer::Descriptor & desc, const Size & size, const size_t & count, const bool & createInCurrentContext=false);
 		
-		//!	You must call this periodically (once per render loop after you finish drawing is usually a good time to call this).  This function frees any buffers that have been sitting unused in the pool for "too long".
+		//!	You must call this periodically (once per render loop after you finish drawing is usually a good time to call this).  This function frees any buffers that have been sitting unused in the pool for "too long"- or, if the pool has a byte budget, frees the least-recently-used buffers until the pool is within its budget.  The GL resources of buffers that were released since the last call are deleted here, in batches.
 		void housekeeping();
 		//!	If needed you can call this to release all inactive buffers in the pool.
 		void purge();
+		
+		/*!
+		\brief Sets the number of bytes of VRAM/RAM the pool's resources may occupy.
+		\param n If non-zero, free buffers are no longer released after sitting idle for a number of housekeeping() calls- instead, the least-recently-used free buffers are released whenever the pool's resident bytes exceed this budget.  Zero (the default) disables the budget.
+		*/
+		void setByteBudget(const size_t & n);
+		//!	Returns the byte budget, or zero if the pool doesn't have one.
+		inline size_t byteBudget() const { return _byteBudget; }
+		//!	Returns the number of bytes occupied by resources the pool created which haven't been released yet (this includes both free buffers and buffers that are still in use).
+		inline size_t residentBytes() const { return _residentBytes; }
+		//!	Returns the highest value residentBytes() has reached since the pool was created or resetPeakResidentBytes() was called.
+		inline size_t peakResidentBytes() const { return _peakResidentBytes; }
+		//!	Resets the value returned by peakResidentBytes() to the current resident byte count.
+		inline void resetPeakResidentBytes() { _peakResidentBytes = _residentBytes.load(); }
+		//!	Returns the number of bytes occupied by free buffers that are waiting to be recycled.
+		inline size_t freeBytes() const { return _freeBytes; }
+		//!	Sets the allocator used to allocate the memory that backs CPU buffers and CPU-backed textures.  Passing null restores the default allocator (a GLPooledCPUBackingAllocator).
+		void setCPUBackingAllocator(const GLCPUBackingAllocatorRef & n);
+		//!	Returns the allocator used to allocate the memory that backs CPU buffers and CPU-backed textures.
+		GLCPUBackingAllocatorRef cpuBackingAllocator() const;
+		//!	Returns a snapshot of the pool's counters (cache hits and misses, GL objects created and destroyed, bytes in use, etc).  Cheap enough to call every frame.
+		Stats stats() const;
+		//!	Resets the pool's counters to zero (and the peak resident byte count to the current resident byte count).  The byte counts in the snapshot reflect the pool's current state, and aren't reset.
+		void resetStats();
 		//!	Returns a timestamp generated for the current time
 		inline Timestamp getTimestamp() const { return Timestamp()-_baseTime; }
 		//!	Timestamps the passed buffer with the current time
@@ -89,10 +305,33 @@ class VVGL_EXPORT GLBufferPool	{
 		void flush();
 	
 	private:
-		//	Called by GLBuffer when it's being deallocated if the buffer has determined that it is a candidate for recycling
+		//	Creates a new buffer (does not check the free buffers for one that matches).  If 'inName' is non-zero it's used as the buffer's GL name instead of generating one.
+		GLBufferRef createNewBufferRef(const GLBuffer::Descriptor & desc, const Size & size, const void * backingPtr, const Size & backingSize, const bool & createInCurrentContext, const uint32_t & inName=0);
+		//	Called by GLBuffer when it's being deallocated if the buffer has determined that it is a candidate for recycling (only happens for buffers that weren't vended with a RecyclingDeleter- the buffer is copied)
 		void returnBufferToPool(VVGL::GLBuffer * inBuffer);
+		//	Called by RecyclingDeleter when the last ref to a buffer is released.  Returns true if the pool took ownership of the passed buffer, false if the caller should delete it.
+		bool recycleBuffer(VVGL::GLBuffer * inBuffer);
+		//	Moves the passed buffer into this thread's cache of free buffers
+		void addToThreadCache(FreeBuffer && inBuffer);
+		//	Makes a GLBufferRef for a buffer that's owned by the pool
+		static GLBufferRef makeBufferRef(VVGL::GLBuffer * inBuffer);
 		//	Called by GLBuffer when it's being deallocated if the buffer has determined that its GL resources need to be released immediately
 		void releaseBufferResources(VVGL::GLBuffer * inBuffer);
+		//	Pushes the passed GL resource onto the deletion queue (safe to call from any thread)
+		void queueDeletion(const GLBuffer::Type & inType, const uint32_t & inName);
+		//	Deletes every GL resource in the deletion queue, grouping them by type so each type is deleted with a single call
+		void deleteQueuedResources();
+		//	Returns the calling thread's cache of free buffers (creating it if necessary), locked by 'outLock'
+		ThreadCache * threadCache(std::unique_lock<std::mutex> & outLock);
+		//	Moves the buffers in every thread's cache to the shared free lists, and stops tracking the caches of threads that have exited
+		void flushThreadCaches();
+		//	Inserts the passed buffers in the shared free lists (caller must have a lock on '_freeBuffersLock')
+		void addToFreeBuffers(const std::vector<FreeBuffer>::iterator & inBegin, const std::vector<FreeBuffer>::iterator & inEnd);
+		//	Removes free buffers from the pool (least-recently-used first) until the resident bytes plus 'inBytesNeeded' fit within the byte budget, and returns them.  The caller releases them (after any locks have been relinquished).
+		std::vector<std::unique_ptr<GLBuffer>> evictFreeBuffersToFit(const size_t & inBytesNeeded);
+		//	Accounting for resources created/released by the pool
+		void addResidentBytes(const size_t & n);
+		void subtractResidentBytes(const size_t & n);
 		
 		friend GLBuffer::~GLBuffer();
 };
@@ -307,6 +546,38 @@ VVGL_EXPORT GLBufferRef CreateRGBATex(const Size & size, const bool & createInCu
 \param inPoolRef The pool that the GLBuffer should be created with.  When the GLBuffer is freed, its underlying GL resources will be returned to this pool (where they will be either freed or recycled).
 */
 VVGL_EXPORT GLBufferRef CreateRGBAFloatTex(const Size & size, const bool & createInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+/*!
+\ingroup VVGL_BUFFERCREATE
+\brief Creates and returns several OpenGL textures that have an internal RGBA format and are 8 bits per component (32 bit color).  This is faster than calling CreateRGBATex() repeatedly- see GLBufferPool::createBufferRefs().
+\param size The size of the buffers to create (in pixels).
+\param count The number of buffers to create.
+\param createInCurrentContext If true, the GL resources will be created in the current context (assumes that a GL context is active in the current thread).  If false, the GL resources will be created by the GL context owned by the buffer pool.
+\param inPoolRef The pool that the GLBuffers should be created with.  When the GLBuffers are freed, their underlying GL resources will be returned to this pool (where they will be either freed or recycled).
+*/
+VVGL_EXPORT std::vector<GLBufferRef> CreateRGBATexArray(const Size & size, const size_t & count, const bool & createInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+/*!
+\ingroup VVGL_BUFFERCREATE
+\brief Creates and returns several OpenGL textures that have an internal RGBA format and are 32 bits per component (128 bit color).  This is faster than calling CreateRGBAFloatTex() repeatedly- see GLBufferPool::createBufferRefs().
+\param size The size of the buffers to create (in pixels).
+\param count The number of buffers to create.
+\param createInCurrentContext If true, the GL resources will be created in the current context (assumes that a GL context is active in the current thread).  If false, the GL resources will be created by the GL context owned by the buffer pool.
+\param inPoolRef The pool that the GLBuffers should be created with.  When the GLBuffers are freed, their underlying GL resources will be returned to this pool (where they will be either freed or recycled).
+*/
+VVGL_EXPORT std::vector<GLBufferRef> CreateRGBAFloatTexArray(const Size & size, const size_t & count, const bool & createInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+/*!
+\ingroup VVGL_BUFFERCREATE
+\brief Asynchronously creates an OpenGL texture that has an internal RGBA format and is 8 bits per component (32 bit color).  See GLBufferPool::createBufferRefAsync() for details.
+\param size The size of the buffer to create (in pixels).
+\param inPoolRef The pool that the GLBuffer should be created with.  When the GLBuffer is freed, its underlying GL resources will be returned to this pool (where they will be either freed or recycled).
+*/
+VVGL_EXPORT std::shared_future<GLBufferRef> CreateRGBATexAsync(const Size & size, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+/*!
+\ingroup VVGL_BUFFERCREATE
+\brief Asynchronously creates an OpenGL texture that has an internal RGBA format and is 32 bits per component (128 bit color).  See GLBufferPool::createBufferRefAsync() for details.
+\param size The size of the buffer to create (in pixels).
+\param inPoolRef The pool that the GLBuffer should be created with.  When the GLBuffer is freed, its underlying GL resources will be returned to this pool (where they will be either freed or recycled).
+*/
+VVGL_EXPORT std::shared_future<GLBufferRef> CreateRGBAFloatTexAsync(const Size & size, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
 
 #if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
 /*!
@@ -440,8 +711,8 @@ VVGL_EXPORT GLBufferRef CreateCubeTexFromImagePaths(const std::vector<std::strin
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+//	PBOs aren't available in ES 2
+#if !defined(VVGL_TARGETENV_GLES)
 
 /*!
 \name PBO creation functions
@@ -475,6 +746,11 @@ decoding "GL_STREAM_DRAW, GL_STREAM_READ, etc:
 VVGL_EXPORT GLBufferRef CreateRGBAPBO(const GLBuffer::Target & inTarget, const int32_t & inUsage, const Size & inSize, const void * inData=nullptr, const bool & inCreateInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
 /*!
 \ingroup VVGL_BUFFERCREATE
+\brief Creates several PBOs at once, each of which has an uninitialized data store large enough for an RGBA image of the passed size.  See the documentation of CreateRGBAPBO() for more information- this is faster than calling it repeatedly (see GLBufferPool::createBufferRefs()).
+*/
+VVGL_EXPORT std::vector<GLBufferRef> CreateRGBAPBOArray(const GLBuffer::Target & inTarget, const int32_t & inUsage, const Size & inSize, const size_t & inCount, const bool & inCreateInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+/*!
+\ingroup VVGL_BUFFERCREATE
 \brief Creates a GLBufferRef that represents a PBO.  See the documentation of CreateRGBAPBO() for more information- PBOs do not contain inherently typed data, these functions only differ in the contents of the GLBuffer::Descriptor they populate.
 */
 VVGL_EXPORT GLBufferRef CreateBGRAPBO(const int32_t & inTarget, const int32_t & inUsage, const Size & inSize, const void * inData=nullptr, const bool & inCreateInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
@@ -492,11 +768,13 @@ VVGL_EXPORT GLBufferRef CreateBGRAFloatPBO(const int32_t & inTarget, const int32
 \ingroup VVGL_BUFFERCREATE
 \brief Creates a GLBufferRef that represents a PBO.  See the documentation of CreateRGBAPBO() for more information- PBOs do not contain inherently typed data, these functions only differ in the contents of the GLBuffer::Descriptor they populate.
 */
+#if !defined(VVGL_TARGETENV_GLES3)
 VVGL_EXPORT GLBufferRef CreateYCbCrPBO(const int32_t & inTarget, const int32_t & inUsage, const Size & inSize, const void * inData=nullptr, const bool & inCreateInCurrentContext=false, const GLBufferPoolRef & inPoolRef=GetGlobalBufferPool());
+#endif	//	!defined(VVGL_TARGETENV_GLES3)
 
 ///@}
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 
 
 
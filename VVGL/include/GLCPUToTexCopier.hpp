@@ -3,15 +3,17 @@
 
 #include "VVGL_Defines.hpp"
 #include "GLBufferPool.hpp"
+#include "VVGL_AdaptiveQueueDepth.hpp"
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+//	none of this stuff should be available if we're running ES 2 (there are no PBOs)
+#if !defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -25,7 +27,7 @@ namespace VVGL
 //! Uploads CPU-based GLBuffers (Type_CPU) to textures.
 /*!
 \ingroup VVGL_BASIC
-Offers both immediate upload and n-buffered texture uploads for double-/triple-/n-buffering/ping-ponging.  Uses PBOs for async DMA.
+Offers both immediate upload and n-buffered texture uploads for double-/triple-/n-buffering/ping-ponging.  Uses PBOs for async DMA.  Available on desktop GL and ES3 (PBOs are mapped with glMapBufferRange() on ES3, which doesn't support YCbCr buffers, byte swapping or persistent mapping).
 */
 
 class VVGL_EXPORT GLCPUToTexCopier	{
@@ -36,13 +38,48 @@ class VVGL_EXPORT GLCPUToTexCopier	{
 		std::queue<GLBufferRef>		_cpuQueue;	//	queue of CPU-based images
 		std::queue<GLBufferRef>		_pboQueue;	//	queue of PBOs
 		std::queue<GLBufferRef>		_texQueue;	//	queue of textures
+		std::deque<GLsync>		_fenceQueue;	//	queue of fences, one per queued upload- signaled when the upload to its texture has completed.  null if the context doesn't support fences.
 		bool					_swapBytes = false;
+		
+		bool					_adaptiveQueueSize = false;	//	if true, '_queueSize' follows '_adaptiveDepth'
+		AdaptiveQueueDepth		_adaptiveDepth;	//	mirrors the queues, timing each upload from the time it's started to the time its fence is signaled
+		
+		bool					_persistentMapping = false;	//	if true (and the context supports ARB_buffer_storage), streamed uploads go through '_uploadRing' instead of pooled PBOs
+		struct UploadRing;
+		std::shared_ptr<UploadRing>		_uploadRing = nullptr;	//	the ring is retained by every CPU buffer that points into it, so it outlives the copier if necessary
 		GLBufferPoolRef			_privatePool = nullptr;	//	by default this is null and the scene will try to use the global buffer pool to create interim resources (temp/persistent buffers).  if non-null, the scene will use this pool to create interim resources.
 	
 	private:
 		//	before calling either of these functions, _queueLock should be locked and a GL context needs to be made current on this thread.
 		void _beginProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer);
-		void _finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer);
+		//	if 'inFence' is true (and the context supports them), returns a fence that's signaled when the upload from the PBO to the texture has completed.
+		GLsync _finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const bool & inFence=false);
+		//	binds the PBO with the passed name and uploads its contents (starting at the passed offset) to the texture.  doesn't flush.
+		void _uploadFromPBO(const GLBufferRef & inCPUBuffer, const uint32_t & inPBOName, const size_t & inPBOOffset, const GLBufferRef & inTexBuffer);
+		
+		//	returns true if the copier should (and can) use the persistently-mapped ring for streamed uploads
+		bool _ringAvailable();
+		//	makes sure '_uploadRing' exists and has slots large enough for the passed number of bytes.  returns false if the ring couldn't be created.
+		bool _ensureRing(const size_t & inSlotBytes, const bool & createInCurrentContext);
+		//	claims a slot in '_uploadRing' that isn't busy, waiting (if necessary) until the GPU has finished uploading its previous contents.  returns the slot's index, or -1 if every slot is busy.
+		int _claimRingSlot();
+		//	returns the index of the slot in '_uploadRing' that starts at the passed address, or -1 if it isn't in the ring.
+		int _ringSlotForPtr(const void * inPtr);
+		//	uploads the passed CPU buffer to the texture from the passed slot of '_uploadRing' (copying it into the slot first if 'inCopyToSlot' is true, and then releasing the slot), fences the slot, and flushes.  returns a separate fence for the queue that's signaled when the upload has completed.
+		GLsync _beginRingProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inTexBuffer, const int & inSlot, const bool & inCopyToSlot);
+		//	deletes the fences of '_uploadRing' (in the current context) and releases it
+		void _destroyRing();
+		//	returns the number of uploads the ring must be able to hold- the largest the queue can get, plus two
+		int _ringSlotCount();
+		
+		//	pops the oldest upload off the queues without finishing it
+		void _dropUpload();
+		//	makes the queue context current if there are queued fences (or a ring) to delete.  only the setters call this- the stream paths delete fences in whatever context is current.
+		void _makeQueueCtxCurrentForDrops();
+		//	checks the fences of the queued uploads (oldest first, without waiting) and reports the ones that have been signaled to '_adaptiveDepth'
+		void _measureTransfers();
+		//	if the queue size is adaptive, makes '_queueSize' match '_adaptiveDepth', dropping the oldest uploads if the queue shrank
+		void _applyAdaptiveDepth();
 	
 	public:
 		GLCPUToTexCopier();
@@ -60,13 +97,56 @@ class VVGL_EXPORT GLCPUToTexCopier	{
 		//!	Returns the size of the queue used for streaming.
 		inline int queueSize() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _queueSize; };
 		
+		//!	Sets whether or not the queue size is chosen automatically.  Off by default.
+		/*!
+		When enabled, each streamed upload is fenced after the glTexSubImage2D() that uploads it to its texture, and timed from the time it's started until the GPU signals the fence (checked without waiting whenever the copier is called, so the resolution is the interval between calls).  If an upload is popped before it has completed (so whatever uses the texture would have to wait for it), the queue grows by one.  If a long run of uploads would have completed in time with one less upload in flight, the queue shrinks by one- like setQueueSize(), this drops the oldest upload in flight.  The queue size stays within the limits passed to setAdaptiveQueueLimits(), and is kept short enough to honor the target latency if there is one.  queueSize() returns the size currently chosen.  Requires a context that supports fences (GL 3.3+ or ES 3)- otherwise the queue size doesn't change.  Uploads that go through the persistently-mapped ring are timed the same way (the ring sizes itself for the largest queue allowed).
+		*/
+		void setAdaptiveQueueSize(const bool & n);
+		//!	Returns whether or not the queue size is chosen automatically.
+		inline bool adaptiveQueueSize() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveQueueSize; };
+		//!	Sets the smallest and largest queue size the adaptive mode may choose.  1 and 4 by default.
+		void setAdaptiveQueueLimits(const int & inMin, const int & inMax);
+		//!	Sets the latency (in seconds) the adaptive mode should stay within, measured as the queue size times the interval between uploads.  If the target can't be met without stalling, the target wins.  0 (the default) means "as little latency as possible without stalling".
+		void setTargetLatency(const double & inSeconds);
+		//!	Returns the latency (in seconds) the adaptive mode should stay within.
+		inline double targetLatency() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveDepth.targetLatency(); };
+		//!	Returns the smoothed time (in seconds) between starting a streamed upload and the GPU completing the upload to its texture, or 0 if nothing has been measured yet.  Measured whether or not the adaptive mode is enabled.
+		inline double measuredLatency() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveDepth.measuredLatency(); };
+		
 		void setSwapBytes(const bool & n) { std::lock_guard<std::recursive_mutex> lock(_queueLock); _swapBytes=n; }
 		bool swapBytes() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _swapBytes; }
 		
+		//!	Sets whether or not streamed uploads should use a persistently-mapped PBO ring.  Off by default.
+		/*!
+		When enabled (and the context supports ARB_buffer_storage, which is core in GL 4.4), streamCPUToTex() copies the CPU data into the next free slot of a single large PBO that stays mapped for the lifetime of the ring, and uploads it with a single glTexSubImage2D() from that slot's offset- there's no per-frame map/unmap, and no pooled PBOs.  Each slot is guarded by a fence, and the ring has queueSize()+2 slots (or the largest adaptive queue size+2).  If you use nextPersistentRingBuffer() to get the CPU buffer you write into, the copy is skipped entirely.  Falls back to the pooled PBO path if every slot is in use, or if the context doesn't support persistent mapping.
+		*/
+		void setPersistentMapping(const bool & n);
+		//!	Returns whether or not streamed uploads should use a persistently-mapped PBO ring.
+		bool persistentMapping() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _persistentMapping; }
+		//!	Returns true if persistent mapping is enabled and supported by the copier's context.
+		bool persistentMappingAvailable();
+		//!	Returns a CPU buffer whose backing is a free slot of the persistently-mapped ring, or null if persistent mapping isn't enabled/available or every slot is in use.
+		/*!
+		Write your image data directly into the returned buffer, then pass it to streamCPUToTex()- the upload happens directly from the slot without any copies.  The buffer retains the ring, and its slot isn't reused until the buffer has been freed (and the upload from it has completed), so it stays valid even if the copier's queue is cleared or resized.  Don't write to it again while an upload from it may be in flight.
+		\param inSize The dimensions of the image, in pixels.
+		\param inPixelFormat Must be PF_RGBA, PF_BGRA, or PF_YCbCr_422.
+		\param inFloat Whether or not the buffer has 32-bit float components (only valid for RGBA and BGRA).
+		*/
+		GLBufferRef nextPersistentRingBuffer(const Size & inSize, const GLBuffer::PixelFormat & inPixelFormat=GLBuffer::PF_RGBA, const bool & inFloat=false, const bool & createInCurrentContext=false);
+		
 		//!	Immediately uploads the passed CPU-based buffer to a GL texture- doesn't use the queues.  Less efficient.  Good for quick single-shot texture uploads.
 		GLBufferRef uploadCPUToTex(const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext=false);
 		//!	Immediately uploads the passed CPU-based buffer to the passed GL texture- doesn't use the queues.  Less efficient.  Good for quick single-shot texture uploads.  Does not check the format or dimensions of the passed texture- make sure it's correct before calling!
 		GLBufferRef uploadCPUToTex(const GLBufferRef & inCPUBuffer, const GLBufferRef & inTexBuffer, const bool & createInCurrentContext=false);
+		//!	Immediately uploads the passed regions of the CPU-based buffer to the passed (existing) GL texture- the rest of the texture is left alone.  Doesn't use the queues.
+		/*!
+		\param inCPUBuffer This must be a CPU-based GLBuffer.  This may not be null.
+		\param inTexBuffer The texture to update.  This may not be null, and it should have the same format and dimensions as the CPU buffer (they aren't checked).
+		\param inDirtyRects The regions of the CPU buffer that have changed, in pixels (the CPU buffer's pixel coordinates are also the texture's).  Rects are clipped to the buffers, and rects that overlap or touch are coalesced if doing so doesn't add much area.  If empty, nothing is uploaded.
+		\param createInCurrentContext Defaults to false- if true, any GL resources will be created by the current GL context in the calling thread.  If false, the local var _queueCtx will be used.
+		Only the dirty regions are copied into a pooled PBO (at their positions in the frame), and each region is uploaded with its own glTexSubImage2D() using GL_UNPACK_ROW_LENGTH/GL_UNPACK_SKIP_PIXELS/GL_UNPACK_SKIP_ROWS- so the CPU copy and the DMA transfer are proportional to the dirty area rather than the frame.  Returns the texture, or null if the upload failed.
+		*/
+		GLBufferRef uploadCPUToTex(const GLBufferRef & inCPUBuffer, const GLBufferRef & inTexBuffer, const std::vector<Rect> & inDirtyRects, const bool & createInCurrentContext=false);
 		
 		//! Begins uploading the passed CPU-based buffer to a GL texture, but stashes it in a queue and will return the texture when this function is called again at a later time (ping-pong/double-/triple-/n-buffering).  Good for streaming texture upload.
 		/*!
@@ -111,7 +191,7 @@ inline GLCPUToTexCopierRef CreateGLCPUToTexCopierRefUsing(const GLContextRef & i
 
 
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -263,6 +263,19 @@ class VVGL_EXPORT GLScene	{
 		virtual void _reshape();
 		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.
 		virtual void _renderCleanup();
+		
+		//	returns true if the passed buffer is a texture that _clearTextures() can fill in this scene's context (GL 3.3+/ES3, RGBA/BGRA)
+		bool _canClearWithoutDraw(const GLBufferRef & n);
+		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.  fills every texture in 'inTexs' with 'inColor' (and 'inDepth', if non-null, with 1.0) without compiling/binding a program or drawing- uses glClearTexImage() where available, otherwise attaches each texture to 'inFBO' in turn and calls glClearBufferfv().  every texture must pass _canClearWithoutDraw().
+		void _clearTextures(const std::vector<GLBufferRef> & inTexs, const GLColor & inColor, const GLBufferRef & inFBO, const GLBufferRef & inDepth=nullptr);
+		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.  clears the passed render target's attachments via _clearTextures() and returns true, or returns false if the target needs a full render pass to be cleared (the default framebuffer or unsupported textures).  the render prep/cleanup callbacks aren't called for direct clears
+		bool _clearWithoutDraw(const RenderTarget & inRenderTarget, const GLColor & inColor);
+		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.  returns the path of the file in the program binary cache that corresponds to the current shader strings and GL renderer/version, or an empty string if the cache is disabled or the context can't retrieve program binaries.  'outCheck' is populated with a second hash of the same values, which is stored in the file and verified when it's loaded.
+		std::string _programBinaryCachePath(uint64_t & outCheck);
+		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.  tries to populate '_program' with the binary cached at the passed path.  returns false (and deletes the file) if the binary is missing, stale or rejected by the driver.
+		bool _loadProgramBinary(const std::string & inPath, const uint64_t & inCheck);
+		//	assumed that _renderLock was obtained before calling.  assumed that context is non-null and has been set as current GL context before calling.  writes the binary of '_program' (which must be linked) to the passed path.
+		void _saveProgramBinary(const std::string & inPath, const uint64_t & inCheck);
 };
 
 
@@ -278,6 +291,18 @@ inline GLSceneRef CreateGLSceneRef() { return std::make_shared<VVGL::GLScene>();
 \brief Creates and returns a GLScene.  The scene uses the passed GL context to do its drawing.
 */
 inline GLSceneRef CreateGLSceneRefUsing(const GLContextRef & inCtx) { return std::make_shared<VVGL::GLScene>(inCtx); }
+/*!
+\relatedalso GLScene
+\brief Sets the directory used to cache linked GL programs, which is empty (disabled) by default.
+\param inDir The path to an existing directory.  Pass an empty string to disable the cache.
+When the cache is enabled, scenes look for a binary of their program (keyed by a hash of the vertex/geometry/fragment shader source and the GL renderer and version strings) before compiling anything, and store the binary after a successful link.  Binaries the driver rejects are deleted and the program is compiled from source as usual.  Requires GL 4.1 (or ARB_get_program_binary) or ES 3, and a driver that supports at least one binary format- otherwise the cache is ignored.  Scenes with a pre-link callback always compile from source, as the cache can't know what the callback does.
+*/
+VVGL_EXPORT void SetGlobalProgramBinaryCacheDir(const std::string & inDir);
+/*!
+\relatedalso GLScene
+\brief Returns the directory used to cache linked GL programs, or an empty string if the cache is disabled.
+*/
+VVGL_EXPORT std::string GetGlobalProgramBinaryCacheDir();
 
 
 
@@ -3,15 +3,18 @@
 
 #include "VVGL_Defines.hpp"
 #include "GLBufferPool.hpp"
+#include "VVGL_AdaptiveQueueDepth.hpp"
 
 #include <mutex>
 #include <queue>
+#include <functional>
+#include <future>
 
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+//	none of this stuff should be available if we're running ES 2 (there are no PBOs)
+#if !defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -25,10 +28,19 @@ namespace VVGL
 //!	Downloads texture-based GLBuffers (Type_Tex) to CPU memory.
 /*!
 \ingroup VVGL_BASIC
-Offers both immediate download and n-buffered texture downloads for double-/triple-/n-buffering/ping-ponging.  Uses PBOs for async DMA.
+Offers both immediate download and n-buffered texture downloads for double-/triple-/n-buffering/ping-ponging.  Uses PBOs for async DMA.  Available on desktop GL and ES3 (PBOs are mapped with glMapBufferRange() and transfers are fenced on ES3, which doesn't support YCbCr buffers, GPU download conversion or persistent mapping).
 */
 
 class VVGL_EXPORT GLTexToCPUCopier	{
+	public:
+		//!	Describes the pixel format textures are converted to (on the GPU) before they're read back.
+		enum DownloadFormat	{
+			DownloadFormat_Native = 0,	//!<	No conversion- the texture is read back in its own pixel format.
+			DownloadFormat_BGRA8,	//!<	8-bit BGRA.  Downloads are BGRA buffers with the same dimensions as the texture.
+			DownloadFormat_UYVY,	//!<	8-bit 4:2:2 YCbCr (Cb Y0 Cr Y1, BT.709 video range).  Downloads are PF_YCbCr_422 buffers with the same dimensions as the texture.  The texture's width must be even.
+			DownloadFormat_NV12	//!<	8-bit 4:2:0 YCbCr (BT.709 video range), a full-res Y plane followed by a half-res interleaved CbCr plane.  Downloads are RGBA buffers a quarter as wide and 1.5x as tall as the texture, so each row is 'width' bytes.  The texture's width must be a multiple of 4, and its height must be even.
+		};
+	
 	private:
 		std::recursive_mutex			_queueLock;	//	this should be used to serialize access to all member vars
 		GLContextRef			_queueCtx = nullptr;	//	this is the context used to perform all GL action
@@ -37,13 +49,71 @@ class VVGL_EXPORT GLTexToCPUCopier	{
 		std::queue<GLBufferRef>		_pboQueue;	//	queue of PBOs
 		std::queue<GLBufferRef>		_texQueue;	//	queue of textures
 		std::queue<GLBufferRef>		_fboQueue;	//	queue of FBOs.  the fastest texture download pipeline involves attaching the texture to an FBO so we can use glReadPixels() instead of glGetTexImage().
+		std::deque<GLsync>		_fenceQueue;	//	queue of fences, one per queued PBO- signaled when the PBO's transfer has completed.  null if the context doesn't support fences.
+		
+		bool					_adaptiveQueueSize = false;	//	if true, '_queueSize' follows '_adaptiveDepth'
+		AdaptiveQueueDepth		_adaptiveDepth;	//	mirrors the queues, timing each download from the time it's started to the time its fence is signaled
+		
+		bool					_persistentMapping = false;	//	if true (and the context supports ARB_buffer_storage), streamed downloads go into a persistently-mapped ring instead of pooled PBOs
+		struct ReadbackRing;
+		std::shared_ptr<ReadbackRing>	_readbackRing = nullptr;	//	the ring is retained by every download in it and every CPU buffer that points into it, so it outlives the copier if necessary
+		std::queue<std::pair<std::shared_ptr<ReadbackRing>,int>>	_ringSlotQueue;	//	queue of ring slots, or (null, -1) if the corresponding download doesn't use the ring
+		
+		//	everything needed to finish a download that's been started
+		struct PendingDownload	{
+			GLBufferRef			cpu = nullptr;
+			GLBufferRef			pbo = nullptr;
+			GLBufferRef			tex = nullptr;
+			GLBufferRef			fbo = nullptr;
+			GLsync				fence = nullptr;
+			std::shared_ptr<ReadbackRing>	ring = nullptr;
+			int					slot = -1;
+			GLBufferPoolRef		pool = nullptr;
+		};
+		struct AsyncDownloader;
+		std::shared_ptr<AsyncDownloader>	_asyncDownloader = nullptr;	//	lazily created by downloadAsync().  has its own GL context (which shares _queueCtx) and thread.
+		
+		DownloadFormat			_downloadFormat = DownloadFormat_Native;
+		GLTexToTexCopierRef		_converters[4];	//	lazily-created scenes that render textures into the download format- BGRA8, UYVY, NV12 luma, NV12 chroma
+		GLTexToTexCopierRef		_scaler = nullptr;	//	lazily-created scene that renders textures into smaller textures for downscaled downloads
 		
 		GLBufferPoolRef			_privatePool = nullptr;	//	by default this is null and the scene will try to use the global buffer pool to create interim resources (temp/persistent buffers).  if non-null, the scene will use this pool to create interim resources.
 		
 	private:
 		//	before calling either of these functions, _queueLock should be locked and a GL context needs to be made current on this thread.
-		void _beginProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & inFBOBuffer);
+		//	if 'inFence' is true (and the context supports them), returns a fence that's signaled when the transfer into the PBO has completed.
+		//	'inPBOOffset' is the offset (in bytes) into the PBO at which the texture's pixels are written.
+		GLsync _beginProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & inFBOBuffer, const bool & inFence=false, const size_t & inPBOOffset=0);
 		void _finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & inFBOBuffer);
+		//	finishes a download that went into the passed ring slot.  if the CPU buffer is null, returns a CPU buffer that points into the slot (and holds it until it's freed)- else copies the slot into the CPU buffer.
+		GLBufferRef _finishRingProcessing(const GLBufferRef & inCPUBuffer, const std::shared_ptr<ReadbackRing> & inRing, const int & inSlot, const GLBufferRef & inTexBuffer, const GLBufferPoolRef & inPool);
+		//	returns true if the copier should (and can) use the persistently-mapped ring for streamed downloads
+		bool _ringAvailable();
+		//	makes sure '_readbackRing' exists and each of its slots can hold a PBO with the passed format and dimensions.  returns false if the ring couldn't be created.
+		bool _ensureRing(const GLBuffer::PixelFormat & inPixelFormat, const Size & inSize, const bool & createInCurrentContext);
+		//	renders the passed texture's srcRect into pooled 8-bit textures in the download format, scaled to 'inOutputSize' (the UYVY and NV12 formats scale the texture with _scaleTex() first, then convert it).  'outChromaBuffer' is only populated for NV12.  returns false (and leaves the outputs alone) if the texture can't or shouldn't be converted.
+		bool _convertTex(const GLBufferRef & inTexBuffer, const Size & inOutputSize, GLBufferRef & outTexBuffer, GLBufferRef & outChromaBuffer);
+		//	renders the passed texture's srcRect into a pooled texture of the passed size.  returns null if the texture can't be scaled.
+		GLBufferRef _scaleTex(const GLBufferRef & inTexBuffer, const Size & inOutputSize);
+		//	starts downloading the passed texture, populating the passed struct.  returns false if the PBO or FBO couldn't be created.
+		//	'inRegion' is the region of the texture to download (its srcRect if empty), and 'inOutputSize' is the size it's scaled down to (the region's size if empty).
+		bool _startDownload(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext, PendingDownload & outDownload, const Rect & inRegion=Rect(), const Size & inOutputSize=Size());
+		//	finishes the passed download (waiting for its transfer to complete if necessary) and deletes its fence.  doesn't need _queueLock- just a GL context that shares _queueCtx.
+		GLBufferRef _finishDownload(PendingDownload & inDownload);
+		//	pushes the passed texture onto the queues and starts downloading it.  returns false if the PBO or FBO couldn't be created.
+		bool _pushDownload(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext, const Rect & inRegion=Rect(), const Size & inOutputSize=Size());
+		//	pops the oldest download off the queues, and finishes it (maps the PBO, which stalls if the transfer hasn't completed yet)
+		GLBufferRef _popDownload();
+		//	pops the oldest download off the queues without finishing it
+		void _dropDownload();
+		//	makes the queue context current if there are queued fences to delete.  only the setters call this- the stream paths delete fences in whatever context is current.
+		void _makeQueueCtxCurrentForDrops();
+		//	pops every element off the queues
+		void _clearQueues();
+		//	checks the fences of the queued downloads (oldest first, without waiting) and reports the ones that have been signaled to '_adaptiveDepth'
+		void _measureTransfers();
+		//	if the queue size is adaptive, makes '_queueSize' match '_adaptiveDepth', dropping the oldest downloads if the queue shrank
+		void _applyAdaptiveDepth();
 	
 	public:
 		GLTexToCPUCopier();
@@ -58,13 +128,39 @@ class VVGL_EXPORT GLTexToCPUCopier	{
 		//!	Returns the size of the queue used for streaming.
 		inline int queueSize() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _queueSize; };
 		
+		//!	Sets whether or not the queue size is chosen automatically.  Off by default.
+		/*!
+		When enabled, each streamed download is timed from the time it's started to the time the GPU signals its fence (checked without waiting whenever the copier is called, so the resolution is the interval between calls).  If a download has to be finished before its transfer has completed (so the calling thread stalls), the queue grows by one.  If a long run of downloads would have completed in time with one less download in flight, the queue shrinks by one- like setQueueSize(), this drops the oldest download in flight.  The queue size stays within the limits passed to setAdaptiveQueueLimits(), and is kept short enough to honor the target latency if there is one.  queueSize() returns the size currently chosen.  Requires a context that supports fences (GL 3.3+ or ES 3)- otherwise the queue size doesn't change.
+		*/
+		void setAdaptiveQueueSize(const bool & n);
+		//!	Returns whether or not the queue size is chosen automatically.
+		inline bool adaptiveQueueSize() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveQueueSize; };
+		//!	Sets the smallest and largest queue size the adaptive mode may choose.  1 and 4 by default.
+		void setAdaptiveQueueLimits(const int & inMin, const int & inMax);
+		//!	Sets the latency (in seconds) the adaptive mode should stay within, measured as the queue size times the interval between downloads.  If the target can't be met without stalling, the target wins.  0 (the default) means "as little latency as possible without stalling".
+		void setTargetLatency(const double & inSeconds);
+		//!	Returns the latency (in seconds) the adaptive mode should stay within.
+		inline double targetLatency() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveDepth.targetLatency(); };
+		//!	Returns the smoothed time (in seconds) between starting a streamed download and the GPU completing its transfer, or 0 if nothing has been measured yet.  Measured whether or not the adaptive mode is enabled.
+		inline double measuredLatency() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _adaptiveDepth.measuredLatency(); };
+		
 		//! Immediately downloads the passed texture into CPU memory- doesn't use the queues.  Less efficient.  Good for quick single-shot texture downloads.
 		/*!
 		\param inTexBuffer The texture-type GLBuffer that you wish to download to memory.  Must not be null.
 		\param inCPUBuffer May be null (null by default).  If null, this function will return a PBO-type GLBuffer that has been mapped- you can access the pixels at its cpuBackingPtr ivar for analysis, encoding, etc.  If you provide a non-null CPU-type GLBuffer for this param, this function will instead return the CPU-type buffer you provided, after populating it with the contents of the texture.
-		This function downloads the texture immediately- it doesn't use the queue/doesn't do any double-/triple-/n-buffering.  This function is generally less efficient than streamTexToCPU(), but it's still appropriate if you just want to download a texture immediately and aren't doing any extensive streaming.
+		This function downloads the texture immediately- it doesn't use the queue/doesn't do any double-/triple-/n-buffering.  This function is generally less efficient than streamTexToCPU(), but it's still appropriate if you just want to download a texture immediately and aren't doing any extensive streaming.  Only the texture's srcRect is downloaded- see the region version of this function to download a different region, or to scale it down.
 		*/
 		GLBufferRef downloadTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		//!	Immediately downloads a region of the passed texture into CPU memory, optionally scaling it down first.  Otherwise behaves like downloadTexToCPU().
+		/*!
+		\param inTexBuffer The texture-type GLBuffer that you wish to download to memory.  Must not be null.
+		\param inRegion The region of the texture to download, in the same coordinate space as the texture's srcRect.  Clipped to the texture's bounds.  If its size is zero, the texture's srcRect is downloaded.
+		\param inOutputSize The size the region is scaled to before it's read back, for thumbnails/previews/analysis.  If its size is zero (or at least as large as the region), the region isn't scaled.  Scaled downloads are rendered into a smaller texture from the pool (on the GPU, with the copier's own context), so the readback only transfers the scaled pixels.  Regions of YCbCr textures, and downloads with 'createInCurrentContext' set, aren't scaled.
+		\param inCPUBuffer May be null.  If non-null, it should have the dimensions of the returned download.
+		\param createInCurrentContext Defaults to false- if true, the GL operations are performed with the current GL context in the calling thread.
+		The returned buffer has the dimensions of the scaled region (or of the region, if it wasn't scaled).  Only the region's pixels are transferred, so the bandwidth used is reduced by the ratio of the areas.  Combines with setDownloadFormat()- the region is scaled and converted in a single pass for BGRA8, and scaled before it's converted for UYVY and NV12.
+		*/
+		GLBufferRef downloadTexToCPU(const GLBufferRef & inTexBuffer, const Rect & inRegion, const Size & inOutputSize, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
 		
 		//!	Begins downloading the passed texture-based buffer to CPU memory, but stashes it in a queue and will return the CPU-based GLBuffer when this function is called again at a later time (ping-pong/double-/triple-/n-buffering).  Good for streaming texture download.
 		/*!
@@ -73,6 +169,50 @@ class VVGL_EXPORT GLTexToCPUCopier	{
 		This function is more efficient than downloadTexToCPU()- CPU use will probably be lower and execution will return to the calling thread more rapidly, though the queue means that there's more latency (it won't start returning buffers until you submit one or two- depending on the size of the queue).
 		*/
 		GLBufferRef streamTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		//!	Begins downloading a region of the passed texture (optionally scaled down first) and returns the oldest download in the queue.  The region and output size behave as they do in the region version of downloadTexToCPU(), and the queueing behaves as it does in streamTexToCPU().
+		GLBufferRef streamTexToCPU(const GLBufferRef & inTexBuffer, const Rect & inRegion, const Size & inOutputSize, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		
+		//!	Begins downloading the passed texture-based buffer to CPU memory, and returns the oldest download in the queue if its transfer has completed (or null if it hasn't).  Never waits for a transfer to complete unless the queue is full.
+		/*!
+		\param inTexBuffer This must be a texture-based GLBuffer, or null (in which case this behaves like poll()).
+		\param inCPUBuffer May be null (null by default).  See streamTexToCPU().
+		Each download is fenced, and the oldest download is only mapped once its fence has been signaled, so the calling thread doesn't stall waiting on the driver.  Downloads are returned as soon as they're ready, so the latency is only as long as the transfers take- queueSize() is the maximum number of downloads that can be in flight.  If the queue is full, the oldest download is finished regardless (which may stall).  Call poll() to retrieve any other downloads that have completed.  If the GL context doesn't support fences (GL 2), this behaves like streamTexToCPU().
+		*/
+		GLBufferRef tryStreamTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		//!	Returns the oldest download in the queue if its transfer has completed, or null if it hasn't (or if the queue is empty).  Doesn't start a new download, and never waits for a transfer to complete.
+		GLBufferRef poll(const bool & createInCurrentContext=false);
+		
+		//!	The type of the callback passed to downloadAsync().
+		using DownloadCallback = std::function<void(const GLBufferRef & inCPUBuffer)>;
+		//!	Begins downloading the passed texture-based buffer to CPU memory, and passes the finished CPU buffer to the callback on a worker thread as soon as the transfer completes.
+		/*!
+		\param inTexBuffer This must be a texture-based GLBuffer.
+		\param inCallback Called exactly once, on the copier's worker thread (see below for exceptions), with the finished download (which has the texture's contentTimestamp and flippedness)- or null if the download failed.  Callbacks are called in the order the downloads were submitted.
+		\param inCPUBuffer May be null (null by default).  If non-null, the texture is downloaded into it.  If null, the callback is passed a mapped PBO (or a CPU buffer pointing into the readback ring if persistent mapping is enabled).
+		\param createInCurrentContext Defaults to false- if true, the readback is started with the current GL context in the calling thread.  If false, the local var _queueCtx will be used.
+		Independent of the streaming queue- nobody needs to keep calling the copier to get frames out of it.  The worker has its own GL context which shares _queueCtx, and waits on each download's fence so it never maps a PBO before its transfer has completed.  Qt contexts can't be used on other threads, and GL can't order a transfer in one context before a read in another without a fence, so on Qt (and on contexts without fences, like GL 2) the download is finished immediately and the callback is called on the calling thread.  Pending callbacks are called before the copier is freed.
+		*/
+		void downloadAsync(const GLBufferRef & inTexBuffer, const DownloadCallback & inCallback, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		//!	Begins downloading the passed texture-based buffer to CPU memory, and returns a future that's fulfilled (on a worker thread) with the finished CPU buffer.  Behaves like the callback version of downloadAsync().
+		std::future<GLBufferRef> downloadAsync(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer=nullptr, const bool & createInCurrentContext=false);
+		
+		//!	Sets whether or not streamed downloads should use a persistently-mapped readback ring.  Off by default.
+		/*!
+		When enabled (and the context supports ARB_buffer_storage, which is core in GL 4.4), streamTexToCPU()/tryStreamTexToCPU() read the texture into the next free slot of a single large pack buffer that stays mapped for the lifetime of the ring, and each slot is guarded by a fence.  If you don't pass a CPU buffer, the finished download is returned as a read-only CPU buffer that points straight into its slot- the slot isn't reused until that buffer is freed, so there's no map and no copy.  If you pass a CPU buffer, the slot is copied into it and released immediately.  If every slot is in use (or the context doesn't support persistent mapping), downloads fall back to pooled PBOs.
+		*/
+		void setPersistentMapping(const bool & n);
+		//!	Returns whether or not streamed downloads should use a persistently-mapped readback ring.
+		bool persistentMapping() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _persistentMapping; }
+		//!	Returns true if persistent mapping is enabled and supported by the copier's context.
+		bool persistentMappingAvailable();
+		
+		//!	Sets the format that downloads are converted to before they're read back.  DownloadFormat_Native by default.
+		/*!
+		When the format isn't native, textures (including float textures) are rendered through a small conversion shader into a compact 8-bit texture from the pool, and that texture is read back instead- so the GPU does the conversion, and less data crosses the bus.  Applies to every download method.  Requires a GL 3.3+ context- if the context is older, the texture's dimensions don't suit the format, or createInCurrentContext is true (the conversion is rendered with the copier's own context), textures are read back natively.  If you pass a CPU buffer, it should match the converted download (see DownloadFormat).
+		*/
+		void setDownloadFormat(const DownloadFormat & n) { std::lock_guard<std::recursive_mutex> lock(_queueLock); _downloadFormat=n; }
+		//!	Returns the format that downloads are converted to before they're read back.
+		DownloadFormat downloadFormat() { std::lock_guard<std::recursive_mutex> lock(_queueLock); return _downloadFormat; }
 		
 		//!	Sets the receiver's private buffer pool (which should default to null).  If non-null, this buffer pool will be used to generate any GL resources required by this scene.  Handy if you have a variety of GL contexts that aren't shared and you have to switch between them rapidly on a per-frame basis.
 		void setPrivatePool(const GLBufferPoolRef & n) { _privatePool=n; }
@@ -102,7 +242,7 @@ inline GLTexToCPUCopierRef CreateGLTexToCPUCopierRefUsing(const GLContextRef & i
 
 
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -24,17 +24,32 @@ namespace VVGL
 This object copies the image data in a GLBuffer by drawing it while another GLBuffer is bound as the render target.  This performs GL rendering- GLTexToTexCopier is a subclass of GLScene, so it has a GL context it can use.  If you require GLTexToTexCopier to use an existing GLContext to draw, use the constructor that accepts a GLContextRef (much like the GLScene constructor with the same signature)
 */
 class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
+	public:
+		//!	The filters sizeVariantCopy() (and copyToNewBuffer(), if copyAndResize() is enabled) can use to shrink buffers.
+		enum DownscaleFilter	{
+			DownscaleFilter_Bilinear = 0,	//!<	A single bilinear sample per output pixel (the default).  Fastest, but aliases when shrinking by more than 2x.
+			DownscaleFilter_Mipmap,	//!<	The source is copied into a pooled texture, mipmaps are generated for it, and it's drawn with trilinear filtering.
+			DownscaleFilter_Box,	//!<	Each output pixel averages the source pixels it covers.  Each pass shrinks by up to 16x (using up to 8x8 bilinear taps per pixel).
+			DownscaleFilter_Bicubic,	//!<	A separable Catmull-Rom filter, widened by the scale factor.  Two passes, plus box passes first if shrinking by more than 8x.
+			DownscaleFilter_Lanczos	//!<	A separable 3-lobe Lanczos filter, widened by the scale factor.  Sharpest.  Two passes, plus box passes first if shrinking by more than 8x.
+		};
+	
 	private:
 		bool			_copyToIOSurface = false;
 		bool			_copyAndResize = false;
 		Size			_copySize = { 320., 240. };
 		SizingMode		_copySizingMode = SizingMode_Stretch;
+		bool			_fastCopy = true;	//	if true, copies that don't need a shader are performed with glCopyImageSubData()/glBlitFramebuffer()
+		bool			_defaultShaders = true;	//	true while the copier is running the shaders from generalInit()- the fast copy path is only used if this is true, as it skips the shaders entirely
+		DownscaleFilter		_downscaleFilter = DownscaleFilter_Bilinear;
+		GLTexToTexCopierRef		_filterCopiers[5];	//	lazily-created copiers (sharing our context) whose programs perform the filtered passes- box, bicubic h/v, lanczos h/v
 		
 		//GLBufferRef	geoXYVBO = nullptr;
 		//GLBufferRef	geoSTVBO = nullptr;
 		
 #if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
 		GLBufferRef		_vao = nullptr;	//	"owns" its own VBO, used to draw stuff if we're in GL 3
+		GLBufferRef		_batchVAO = nullptr;	//	used to draw batches of copies in GL 3- its VBO is replaced by every batch
 #elif defined(VVGL_TARGETENV_GLES)
 		GLBufferRef		_vbo = nullptr;	//	geometry + tex coords, used to draw stuff if we're in GL ES
 #endif
@@ -46,6 +61,9 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 		GLCachedUni		_isRectTexLoc = GLCachedUni("isRectTex");	//	address of the uniform we use to indicate whether the program should sample the 2D or RECT texture
 		
 	public:
+		//!	Describes a single copy in a batch- the buffer to copy, and the rect (in the destination's pixels) its srcRect is stretched into.
+		using BatchCopy = std::pair<GLBufferRef,Rect>;
+		
 		//!	Creates a new OpenGL context that shares the global buffer pool's context, uses that to create a new GLTexToTexCopier instance
 		GLTexToTexCopier();
 		//!	Uses the passed GL context to create a new GLTexToTexCopier.  No new OpenGL context is created- the buffer copier/scene will use the passed context to do its rendering.
@@ -55,6 +73,11 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 		
 		virtual void prepareToBeDeleted();
 		
+		//!	Overridden so the copier knows it's no longer running its own shaders (copies that skip the shader are disabled).
+		virtual void setVertexShaderString(const std::string & n);
+		//!	Overridden so the copier knows it's no longer running its own shaders (copies that skip the shader are disabled).
+		virtual void setFragmentShaderString(const std::string & n);
+		
 		//!	Sets the _copyToIOSurface flag (Mac SDK only).  If true, buffers created by the copier will be backed by IOSurfaces (and can thus be shared with other processes)
 		void setCopyToIOSurface(const bool & n);
 		//!	Gets the _copyToIOSurface flag (Mac SDK only).
@@ -71,6 +94,20 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 		void setCopySizingMode(const SizingMode & n);
 		//!	Gets the copy sizing mode.
 		SizingMode copySizingMode();
+		//!	Sets whether or not copies may skip the shader.  On by default.
+		/*!
+		When enabled (and the copier is using its own shaders- passing a shader string to the copier disables this), copyFromTo(), sizeVariantCopy() and ignoreSizeCopy() pick the cheapest way to perform each copy from the buffers' descriptors, sizes and flippedness.  Unflipped copies between textures with the same internal format and size use glCopyImageSubData() (GL 4.3/ARB_copy_image), and copies between color-renderable RGBA/BGRA textures that are the same size, or scaled by an integer factor, use glBlitFramebuffer() (GL 3.3+/ES 3), which can also un-flip the source.  Neither clears the destination or uses the program, so they're only used if the copy covers the whole destination (or if the clear is disabled).  Everything else is drawn as a textured quad.
+		*/
+		void setFastCopy(const bool & n);
+		//!	Gets whether or not copies may skip the shader.
+		bool fastCopy();
+		//!	Sets the filter used when sizeVariantCopy() (or copyToNewBuffer(), if copyAndResize() is enabled) shrinks a buffer.  DownscaleFilter_Bilinear by default.
+		/*!
+		Each filter uses the fewest passes it can for the scale factor- shrinking by 2x or less with the mipmap or box filters is a single bilinear draw, and the separable filters only add box passes if they'd need too many taps.  Intermediate textures come from the buffer pool (and are float if the source is).  The filters require GL 3.3+ or ES 3- older contexts always use bilinear filtering.
+		*/
+		void setDownscaleFilter(const DownscaleFilter & n);
+		//!	Gets the filter used when shrinking buffers.
+		DownscaleFilter downscaleFilter();
 		
 		//!	Returns a new GLBuffer which was made by rendering the passed buffer into a new texture of matching dimensions.
 		GLBufferRef copyToNewBuffer(const GLBufferRef & n);
@@ -80,6 +117,13 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 		void sizeVariantCopy(const GLBufferRef & a, const GLBufferRef & b);
 		//!	Copies the first buffer into the second buffer, completely ignoring sizes- it just draws 'a' in the bottom-left corner of 'b'.  the resulting image may depict 'a' as being "too small" or "cropped".
 		void ignoreSizeCopy(const GLBufferRef & a, const GLBufferRef & b);
+		//!	Draws every buffer in the passed vector into the destination buffer in a single render pass.  Good for atlases, thumbnail walls and multiviewers.
+		/*!
+		\param inCopies The buffers to copy, each with the rect (in the destination's pixels, origin in the bottom-left) that its srcRect is stretched into.  Flipped buffers are un-flipped.  Null buffers are skipped.
+		\param inDst The buffer to draw into.  It's cleared first (unless the clear is disabled), so anything not covered by a copy is the clear color.
+		The destination is bound, cleared and flushed once, and the program is used once.  In GL 3+ every copy's geometry and texture coordinates go into a single VBO, and consecutive copies of the same texture are drawn with a single draw call (so the texture is only bound once)- copies are drawn in the order they're passed, so group them by source if they don't overlap.  In older GL versions each copy is drawn separately, but still within a single render pass.
+		*/
+		void copyBatch(const std::vector<BatchCopy> & inCopies, const GLBufferRef & inDst);
 		
 		//!	Fills the passed buffer with transparent black (0., 0., 0., 0.)
 		void copyBlackFrameTo(const GLBufferRef & n);
@@ -87,6 +131,13 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 		void copyOpaqueBlackFrameTo(const GLBufferRef & n);
 		//!	Fills the passed buffer with opaque red (1., 0., 0., 1.)
 		void copyRedFrameTo(const GLBufferRef & n);
+		//!	Fills every buffer in the passed vector with the passed color.
+		/*!
+		\param inBuffers The buffers to fill.  Null buffers are skipped.
+		\param inColor The color to fill them with.
+		In GL 3.3+/ES 3 RGBA/BGRA textures are cleared directly- with glClearTexImage() in GL 4.4, or by attaching each one to a single FBO and calling glClearBufferfv()- so no program is bound and nothing is drawn, and the context is made current and flushed once for the whole batch.  Any other buffers are filled with a render pass, like copyBlackFrameTo().
+		*/
+		void clearBuffers(const std::vector<GLBufferRef> & inBuffers, const GLColor & inColor=GLColor(0., 0., 0., 0.));
 	
 	protected:
 		virtual void _initialize();
@@ -95,6 +146,18 @@ class VVGL_EXPORT GLTexToTexCopier : public GLScene	{
 	private:
 		//	acquire '_renderLock' and set current context before calling
 		void _drawBuffer(const GLBufferRef & inBufferRef, const Quad<VertXYZST> & inVertexStruct);
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+		//	acquire '_renderLock', set current context and use the program before calling.  binds the passed buffer to the texture unit (and sets the uniforms) the program samples.
+		void _bindInputBuffer(const GLBufferRef & inBufferRef);
+		//	acquire '_renderLock', set current context and prep for render before calling.  draws the batch using '_batchVAO'.
+		void _drawBatch(const std::vector<BatchCopy> & inCopies);
+#endif
+		//	acquire '_renderLock' and set current context before calling.  copies the source's srcRect into 'inDstRect' (in the destination's pixels) with glCopyImageSubData() or glBlitFramebuffer() if possible, un-flipping it.  returns false if the copy has to be drawn instead.
+		bool _fastCopyFromTo(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect);
+		//	draws the source's srcRect (un-flipped) into 'inDstRect' of the destination, in a render pass of its own.  may use the fast copy path if 'inFastCopy' is true.
+		void _drawInto(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect, const bool & inFastCopy);
+		//	acquire '_renderLock' and set current context before calling.  shrinks the source's srcRect into 'inDstRect' of the destination with '_downscaleFilter'.  returns false if a single bilinear draw will do.
+		bool _filteredCopy(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect);
 };
 
 
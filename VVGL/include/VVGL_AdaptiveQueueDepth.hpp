@@ -0,0 +1,85 @@
+#ifndef VVGL_AdaptiveQueueDepth_h
+#define VVGL_AdaptiveQueueDepth_h
+
+#include "VVGL_Defines.hpp"
+
+#include <deque>
+#include <chrono>
+
+
+
+
+namespace VVGL
+{
+
+
+
+
+/*!
+\brief Chooses the depth of a streaming copier's queue (the number of transfers it keeps in flight) from the measured latency of its transfers.  The copiers that own an instance of this class mirror their queue in it: every transfer they start is reported with noteSubmission(), transfers that the GPU reports as complete (via their fence) are reported with noteCompletion(), and transfers leaving the queue are reported with notePop() or noteDrop().  The depth grows by one whenever popping a transfer had to wait for it, and shrinks by one after a run of transfers that all completed with time to spare.  Not thread-safe- the owning copier serializes access with its own lock.
+*/
+class VVGL_EXPORT AdaptiveQueueDepth	{
+	private:
+		struct Transfer	{
+			std::chrono::steady_clock::time_point	submitted;
+			double		latency = -1.;	//	seconds between submission and completion, or -1 if not complete yet
+		};
+		
+		int			_minDepth = 1;
+		int			_maxDepth = 4;
+		double		_targetLatency = 0.;	//	seconds.  0 means "as little as possible without stalling".
+		int			_depth = 1;
+		double		_latency = 0.;	//	smoothed transfer latency, in seconds
+		double		_interval = 0.;	//	smoothed time between submissions, in seconds
+		int			_calmCount = 0;	//	consecutive transfers that would have completed in time with a shallower queue
+		std::deque<Transfer>		_inFlight;
+		std::chrono::steady_clock::time_point		_lastSubmission;
+		bool		_hasSubmission = false;
+		
+		void _clampDepth();
+	public:
+		AdaptiveQueueDepth() = default;
+		
+		//!	Sets the smallest and largest depth the queue may have.  The current depth is clamped to the new limits.
+		void setLimits(const int & inMin, const int & inMax);
+		inline int minDepth() const { return _minDepth; }
+		inline int maxDepth() const { return _maxDepth; }
+		//!	Sets the latency (in seconds) the queue should not exceed, measured as depth x the interval between submissions.  If the latency target and stall-free operation conflict, the latency target wins.  0 (the default) disables the target.
+		void setTargetLatency(const double & inSeconds);
+		inline double targetLatency() const { return _targetLatency; }
+		//!	Returns the depth the queue should currently have.
+		inline int depth() const { return _depth; }
+		//!	Sets the depth directly (clamped to the limits), e.g. when the owner's queue size is set manually.
+		void setDepth(const int & n);
+		//!	Returns the smoothed time (in seconds) between a transfer's submission and the GPU's completion of it, or 0 if nothing has been measured yet.
+		inline double measuredLatency() const { return _latency; }
+		//!	Returns the smoothed time (in seconds) between submissions, or 0 if fewer than two transfers have been submitted.
+		inline double submissionInterval() const { return _interval; }
+		//!	Returns the number of transfers currently being tracked.
+		inline int inFlightCount() const { return static_cast<int>(_inFlight.size()); }
+		//!	Returns whether the in-flight transfer at the passed index (0 is the oldest) has been reported as complete.
+		bool isComplete(const int & inIndex) const;
+		
+		//!	Call when a transfer is started (pushed onto the back of the owner's queue).
+		void noteSubmission();
+		//!	Call when the GPU reports that the in-flight transfer at the passed index (0 is the oldest) is complete.
+		void noteCompletion(const int & inIndex);
+		/*!
+		\brief Call when the oldest transfer is popped from the owner's queue so its results can be used.  May change depth().
+		\param inStalled Whether the transfer was still incomplete when it was popped (i.e. the caller will have to wait for it).
+		*/
+		void notePop(const bool & inStalled);
+		//!	Call when the oldest transfer is removed from the owner's queue without its results being used.  Does not change depth().
+		void noteDrop();
+		//!	Forgets all in-flight transfers and timing history.  The limits, target and depth are kept.
+		void reset();
+};
+
+
+
+
+
+}
+
+
+#endif /* VVGL_AdaptiveQueueDepth_h */
@@ -33,6 +33,7 @@ struct GLCachedAttrib;
 struct GLCachedUni;
 class GLTexToCPUCopier;
 class GLCPUToTexCopier;
+class GLCPUBackingAllocator;
 struct Timestamp;
 class GLContextWindowBacking;
 
@@ -97,6 +98,11 @@ using GLTexToCPUCopierRef = std::shared_ptr<GLTexToCPUCopier>;
 \relates VVGL::GLCPUToTexCopier
 */
 using GLCPUToTexCopierRef = std::shared_ptr<GLCPUToTexCopier>;
+/*!
+\brief	A GLCPUBackingAllocatorRef is a shared pointer around a GLCPUBackingAllocator.
+\relates VVGL::GLCPUBackingAllocator
+*/
+using GLCPUBackingAllocatorRef = std::shared_ptr<GLCPUBackingAllocator>;
 
 
 
@@ -0,0 +1,52 @@
+#ifndef VVGL_RowCopy_h
+#define VVGL_RowCopy_h
+
+#include "VVGL_Defines.hpp"
+#include "GLBuffer.hpp"
+
+
+
+
+namespace VVGL
+{
+
+
+
+
+/*!
+\name Row copying functions
+\brief These functions copy image data between CPU-accessible buffers (CPU buffers, mapped PBOs) that may have different strides, optionally converting the pixels as they go.  Large copies are split across a small pool of threads, and use SIMD/non-temporal stores where the CPU supports them.
+*/
+///@{
+//!	Describes the conversion (if any) that CopyRows() performs as it copies each pixel.
+enum RowCopyConversion	{
+	RowCopyConversion_None = 0,	//!<	Bytes are copied as-is.
+	RowCopyConversion_SwapRB,	//!<	8-bit RGBA pixels are copied to 8-bit BGRA (or vice versa).
+	RowCopyConversion_FloatToUByte,	//!<	32-bit float RGBA pixels are clamped to [0, 1] and packed to 8-bit RGBA (or BGRA to BGRA).
+	RowCopyConversion_FloatToUByteSwapRB	//!<	32-bit float RGBA pixels are clamped to [0, 1] and packed to 8-bit BGRA (or vice versa).
+};
+/*!
+\brief Copies rows of image data from one buffer to another.
+\param inSrc The first byte of the first row to copy.
+\param inSrcBytesPerRow The distance (in bytes) between the start of consecutive rows in the source.
+\param inDst The first byte of the first row to write to.
+\param inDstBytesPerRow The distance (in bytes) between the start of consecutive rows in the destination.
+\param inRowBytes The number of source bytes to copy from each row.  Must be a multiple of the source pixel size if a conversion is performed.
+\param inRowCount The number of rows to copy.
+\param inConversion The conversion (if any) to perform on each pixel.  Float conversions write a quarter as many bytes per row as they read.
+*/
+VVGL_EXPORT void CopyRows(const void * inSrc, const size_t & inSrcBytesPerRow, void * inDst, const size_t & inDstBytesPerRow, const size_t & inRowBytes, const size_t & inRowCount, const RowCopyConversion & inConversion=RowCopyConversion_None);
+//!	Returns the conversion CopyRows() should perform to copy pixels described by the first descriptor to pixels described by the second.  Returns RowCopyConversion_None if no conversion is needed (or if it isn't supported).
+VVGL_EXPORT RowCopyConversion RowCopyConversionForDescriptors(const GLBuffer::Descriptor & inSrc, const GLBuffer::Descriptor & inDst);
+//!	Copies the image in the source buffer's CPU backing (or mapped PBO) to the destination buffer's CPU backing, converting the pixels if the buffers' formats differ (8-bit RGBA/BGRA swizzles, float-to-8-bit packing).  Unsupported format combinations are copied byte-for-byte.
+VVGL_EXPORT void CopyBufferRows(const GLBufferRef & inSrc, const GLBufferRef & inDst);
+///@}
+
+
+
+
+
+}
+
+
+#endif /* VVGL_RowCopy_h */
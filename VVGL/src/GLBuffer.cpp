@@ -390,7 +390,7 @@ bool GLBuffer::safeToPublishToSyphon() const	{
 }
 #endif
 
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#if !defined(VVGL_TARGETENV_GLES)
 void GLBuffer::mapPBO(const uint32_t & inAccess, const bool & inUseCurrentContext)	{
 	if (desc.type != Type_PBO || pboMapped)
 		return;
@@ -405,8 +405,20 @@ void GLBuffer::mapPBO(const uint32_t & inAccess, const bool & inUseCurrentContex
 	
 	glBindBuffer(desc.target, name);
 	GLERRLOG
+#if defined(VVGL_TARGETENV_GLES3)
+	//	ES3 doesn't have glMapBuffer()- map the whole buffer with glMapBufferRange() instead
+	GLbitfield		accessBits = 0;
+	switch (inAccess)	{
+	case GL_READ_ONLY:	accessBits = GL_MAP_READ_BIT;	break;
+	case GL_WRITE_ONLY:	accessBits = GL_MAP_WRITE_BIT;	break;
+	default:	accessBits = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;	break;
+	}
+	cpuBackingPtr = glMapBufferRange(desc.target, 0, static_cast<GLsizeiptr>(desc.backingLengthForSize(backingSize)), accessBits);
+	GLERRLOG
+#else
 	cpuBackingPtr = glMapBuffer(desc.target, inAccess);
 	GLERRLOG
+#endif
 	if (cpuBackingPtr != nullptr)
 		pboMapped = true;
 	glBindBuffer(desc.target, 0);
@@ -434,7 +446,7 @@ void GLBuffer::unmapPBO(const bool & inUseCurrentContext)	{
 	cpuBackingPtr = nullptr;
 	pboMapped = false;
 }
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 bool GLBuffer::isContentMatch(GLBuffer & n) const	{
 	return this->contentTimestamp == n.contentTimestamp;
 }
@@ -6,6 +6,11 @@
 
 #include <set>
 #include <algorithm>
+#include <deque>
+#include <condition_variable>
+#include <functional>
+#include <cstring>
+#include <cmath>
 
 #if defined(VVGL_SDK_QT)
 #include <QImage>
@@ -15,8 +20,20 @@
 #include <stb/stb_image.h>
 #endif
 
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <cstdlib>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 
 #define IDLEBUFFERCOUNT 30
+//	the number of free buffers each thread can cache before the oldest half is moved to the pool's shared free lists
+#define THREADCACHESIZE 8
 
 
 
@@ -33,6 +50,351 @@ using namespace std;
 //	this is the global buffer pool
 static GLBufferPoolRef _globalBufferPool = nullptr;
 static GLBufferPoolRef _nullGlobalBufferPool = nullptr;
+//	every buffer pool gets a unique ID
+static atomic<uint64_t> _poolIDCount(0);
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- GLBufferRef control block allocator
+
+
+//	the control blocks of the GLBufferRefs vended by buffer pools are allocated from fixed-size nodes which are recycled (instead of freed)
+#define REFNODESIZE 64
+//	the number of free nodes each thread holds on to before returning them to the shared list
+#define REFNODETHREADCOUNT 64
+
+//	free nodes are stored in a singly-linked list (the first bytes of each free node point to the next free node)
+struct RefNodeList	{
+	void			*head = nullptr;
+	size_t			count = 0;
+	
+	inline void push(void * n) { *(static_cast<void**>(n)) = head; head = n; ++count; }
+	inline void * pop() { void *returnMe = head; if (returnMe != nullptr) { head = *(static_cast<void**>(returnMe)); --count; } return returnMe; }
+};
+//	the shared list of free nodes is never deleted (nodes may be released by other static objects as they're destroyed)
+static mutex & RefNodeSharedLock()	{
+	static mutex		*returnMe = new mutex();
+	return *returnMe;
+}
+static RefNodeList & RefNodeSharedList()	{
+	static RefNodeList		*returnMe = new RefNodeList();
+	return *returnMe;
+}
+//	each thread has its own list of free nodes- when the thread exits, its nodes are moved to the shared list
+struct RefNodeThreadList : public RefNodeList	{
+	~RefNodeThreadList()	{
+		lock_guard<mutex>		lock(RefNodeSharedLock());
+		while (void *node = pop())
+			RefNodeSharedList().push(node);
+	}
+};
+static RefNodeThreadList & RefNodeLocalList()	{
+	static thread_local RefNodeThreadList		returnMe;
+	return returnMe;
+}
+static void * AllocRefNode()	{
+	RefNodeList		&localList = RefNodeLocalList();
+	void			*returnMe = localList.pop();
+	if (returnMe != nullptr)
+		return returnMe;
+	//	if this thread is out of nodes, take a batch of them from the shared list
+	{
+		lock_guard<mutex>		lock(RefNodeSharedLock());
+		RefNodeList		&sharedList = RefNodeSharedList();
+		while (localList.count < REFNODETHREADCOUNT/2 && sharedList.head != nullptr)
+			localList.push(sharedList.pop());
+	}
+	returnMe = localList.pop();
+	if (returnMe == nullptr)
+		returnMe = ::operator new(REFNODESIZE);
+	return returnMe;
+}
+static void FreeRefNode(void * n)	{
+	RefNodeList		&localList = RefNodeLocalList();
+	localList.push(n);
+	//	if this thread is holding too many nodes, give half of them to the shared list
+	if (localList.count > REFNODETHREADCOUNT)	{
+		lock_guard<mutex>		lock(RefNodeSharedLock());
+		RefNodeList		&sharedList = RefNodeSharedList();
+		while (localList.count > REFNODETHREADCOUNT/2)
+			sharedList.push(localList.pop());
+	}
+}
+
+template <typename T>
+struct GLBufferRefAllocator	{
+	using value_type = T;
+	
+	GLBufferRefAllocator() = default;
+	template <typename U> GLBufferRefAllocator(const GLBufferRefAllocator<U> &) {}
+	
+	T * allocate(size_t n)	{
+		if (n==1 && sizeof(T)<=REFNODESIZE && alignof(T)<=alignof(max_align_t))
+			return static_cast<T*>(AllocRefNode());
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T * p, size_t n)	{
+		if (n==1 && sizeof(T)<=REFNODESIZE && alignof(T)<=alignof(max_align_t))
+			FreeRefNode(p);
+		else
+			::operator delete(p);
+	}
+	
+	template <typename U> bool operator==(const GLBufferRefAllocator<U> &) const { return true; }
+	template <typename U> bool operator!=(const GLBufferRefAllocator<U> &) const { return false; }
+};
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- async buffer creation worker
+
+
+struct GLBufferPool::AsyncWorker	{
+	struct Request	{
+		GLBuffer::Descriptor		desc;
+		Size					size;
+		weak_ptr<GLBufferPool>		pool;	//	weak, so pending requests don't keep the pool alive
+		promise<GLBufferRef>		result;
+	};
+	
+	mutex					lock;
+	condition_variable		condition;
+	deque<Request>			requests;
+	bool					quit = false;
+	GLContextRef			context = nullptr;
+	thread					workerThread;
+	
+	AsyncWorker(const GLContextRef & inCtx) : context(inCtx)	{}
+	
+	void start(const shared_ptr<AsyncWorker> & inSelf)	{
+		//	the thread retains the worker, so the worker outlives the pool if the pool is freed on the worker thread
+		workerThread = thread([inSelf]()	{
+			inSelf->run();
+		});
+	}
+	void addRequest(Request && n)	{
+		{
+			lock_guard<mutex>		tmpLock(lock);
+			requests.emplace_back(move(n));
+		}
+		condition.notify_one();
+	}
+	void stop()	{
+		{
+			lock_guard<mutex>		tmpLock(lock);
+			quit = true;
+		}
+		condition.notify_one();
+		//	if the pool is being freed on the worker thread (by the worker releasing the last ref to it), we can't join it
+		if (workerThread.get_id() == this_thread::get_id())
+			workerThread.detach();
+		else if (workerThread.joinable())
+			workerThread.join();
+	}
+	void run()	{
+		context->makeCurrent();
+		while (true)	{
+			Request				request;
+			{
+				unique_lock<mutex>		tmpLock(lock);
+				condition.wait(tmpLock, [&]()	{ return (quit || requests.size()>0); });
+				if (requests.size() < 1)
+					return;
+				request = move(requests.front());
+				requests.pop_front();
+			}
+			
+			//	if the pool has been freed there's nothing to do (the buffer retains the pool, so the pool can't be freed when 'pool' falls out of scope here)
+			GLBufferRef			newBuffer = nullptr;
+			{
+				GLBufferPoolRef		pool = request.pool.lock();
+				if (pool != nullptr)	{
+					newBuffer = pool->createBufferRef(request.desc, request.size, nullptr, Size(), true);
+					if (newBuffer != nullptr)
+						newBuffer->parentBufferPool = pool;
+				}
+			}
+			
+			//	wait until the GPU has finished creating the resource, so it's complete when other contexts in the sharegroup see it
+			if (newBuffer != nullptr)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+				if (context->version==GLVersion_33 || context->version==GLVersion_4 || context->version==GLVersion_ES3)	{
+					GLsync			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+					GLERRLOG
+					glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+					GLERRLOG
+					glDeleteSync(fence);
+					GLERRLOG
+				}
+				else
+#endif
+				{
+					glFinish();
+					GLERRLOG
+				}
+			}
+			
+			request.result.set_value(newBuffer);
+		}
+	}
+};
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- CPU backing allocator
+
+
+#define HUGEPAGESIZE (2*1024*1024)
+
+static size_t PageSize()	{
+#if defined(_WIN32)
+	return 4096;
+#else
+	static const size_t		pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return pageSize;
+#endif
+}
+static void * AllocAligned(const size_t & inLength, const size_t & inAlignment)	{
+#if defined(_WIN32)
+	return _aligned_malloc(inLength, inAlignment);
+#else
+	void			*returnMe = nullptr;
+	if (posix_memalign(&returnMe, inAlignment, inLength) != 0)
+		return nullptr;
+	return returnMe;
+#endif
+}
+static void FreeAligned(void * inPtr)	{
+#if defined(_WIN32)
+	_aligned_free(inPtr);
+#else
+	free(inPtr);
+#endif
+}
+
+
+GLPooledCPUBackingAllocator::GLPooledCPUBackingAllocator(const size_t & inMaxFreeBytes, const bool & inHugePages) : _maxFreeBytes(inMaxFreeBytes), _hugePages(inHugePages)	{
+}
+GLPooledCPUBackingAllocator::~GLPooledCPUBackingAllocator()	{
+	purge();
+}
+void * GLPooledCPUBackingAllocator::allocate(const size_t & n)	{
+	size_t			sizeClass = sizeClassForLength(n);
+	
+	//	try to recycle a block first
+	{
+		lock_guard<mutex>		lock(_lock);
+		auto			blocksIt = _freeBlocks.find(sizeClass);
+		if (blocksIt != _freeBlocks.end() && blocksIt->second.size() > 0)	{
+			void			*returnMe = blocksIt->second.back();
+			blocksIt->second.pop_back();
+			_freeBytes -= sizeClass;
+			return returnMe;
+		}
+	}
+	
+	//	...if we're here we need to allocate a new block
+	size_t			alignment = alignmentForSizeClass(sizeClass);
+	void			*returnMe = AllocAligned(sizeClass, alignment);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (returnMe != nullptr && alignment == HUGEPAGESIZE)
+		madvise(returnMe, sizeClass, MADV_HUGEPAGE);
+#endif
+	return returnMe;
+}
+void GLPooledCPUBackingAllocator::release(void * inPtr, const size_t & n)	{
+	if (inPtr == nullptr)
+		return;
+	size_t			sizeClass = sizeClassForLength(n);
+	{
+		lock_guard<mutex>		lock(_lock);
+		if (_freeBytes + sizeClass <= _maxFreeBytes)	{
+			_freeBlocks[sizeClass].push_back(inPtr);
+			_freeBytes += sizeClass;
+			return;
+		}
+	}
+	FreeAligned(inPtr);
+}
+void GLPooledCPUBackingAllocator::purge()	{
+	unordered_map<size_t, vector<void*>>		tmpBlocks;
+	{
+		lock_guard<mutex>		lock(_lock);
+		swap(tmpBlocks, _freeBlocks);
+		_freeBytes = 0;
+	}
+	for (const auto & blocksIt : tmpBlocks)	{
+		for (const auto & block : blocksIt.second)
+			FreeAligned(block);
+	}
+}
+size_t GLPooledCPUBackingAllocator::sizeClassForLength(const size_t & n)	{
+	if (n <= 64)
+		return 64;
+	//	there are four size classes per power of two: find the largest power of two that's <= n, and round up to a quarter of it
+	size_t			pow2 = 64;
+	while (pow2 <= n/2)
+		pow2 *= 2;
+	size_t			step = max(pow2/4, static_cast<size_t>(64));
+	size_t			returnMe = ((n + step - 1) / step) * step;
+	//	blocks that are a page or larger are a whole number of pages
+	size_t			pageSize = PageSize();
+	if (returnMe >= pageSize)
+		returnMe = ((returnMe + pageSize - 1) / pageSize) * pageSize;
+	return returnMe;
+}
+size_t GLPooledCPUBackingAllocator::freeBytes()	{
+	lock_guard<mutex>		lock(_lock);
+	return _freeBytes;
+}
+size_t GLPooledCPUBackingAllocator::alignmentForSizeClass(const size_t & n) const	{
+	if (_hugePages && n >= HUGEPAGESIZE)
+		return HUGEPAGESIZE;
+	size_t			pageSize = PageSize();
+	if (n >= pageSize)
+		return pageSize;
+	return 64;
+}
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- stats
+
+
+GLBufferPool::Stats::Stats()	{
+	for (int i=0; i<=GLBuffer::Type_VAO; ++i)	{
+		fetchHits[i] = 0;
+		fetchMisses[i] = 0;
+		glObjectsCreated[i] = 0;
+		glObjectsDestroyed[i] = 0;
+	}
+}
+double GLBufferPool::Stats::hitRate() const	{
+	uint64_t		hits = 0;
+	uint64_t		misses = 0;
+	for (int i=0; i<=GLBuffer::Type_VAO; ++i)	{
+		hits += fetchHits[i];
+		misses += fetchMisses[i];
+	}
+	return (hits+misses == 0) ? 0. : static_cast<double>(hits)/static_cast<double>(hits+misses);
+}
+void GLBufferPool::StatCounters::reset()	{
+	for (int i=0; i<=GLBuffer::Type_VAO; ++i)	{
+		fetchHits[i] = 0;
+		fetchMisses[i] = 0;
+		glObjectsCreated[i] = 0;
+		glObjectsDestroyed[i] = 0;
+	}
+	evictions = 0;
+}
 
 
 
@@ -41,15 +403,17 @@ static GLBufferPoolRef _nullGlobalBufferPool = nullptr;
 #pragma mark --------------------- constructor/destructor
 
 
-GLBufferPool::GLBufferPool(const GLContextRef & inCtx)	{
+GLBufferPool::GLBufferPool(const GLContextRef & inCtx) : _returnCount(0), _byteBudget(0), _residentBytes(0), _peakResidentBytes(0), _freeBytes(0), _deletionQueue(nullptr)	{
+	_poolID = ++_poolIDCount;
 	//cout << __PRETTY_FUNCTION__ << endl;
 	//cout << "\tpassed ctx was " << inCtx << endl;
 	//_context = (inShareCtx==nullptr) ? new GLContext() : new GLContext(inShareCtx);
 	//_context = (inShareCtx==nullptr) ? CreateNewGLContextRef() : inShareCtx->newContextSharingMe();
 	_context = (inCtx==nullptr) ? CreateNewGLContextRef() : inCtx;
+	_cpuBackingAllocator = make_shared<GLPooledCPUBackingAllocator>();
 	//cout << "\tcontext is " << *_context << endl;
 	//cout << "\tmy ctx is " << _context << endl;
-	_freeBuffers.reserve(50);
+	_freeBuffers.reserve(25);
 	
 #if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_IOS)
 	_colorSpace = CGColorSpaceCreateDeviceRGB();
@@ -58,6 +422,14 @@ GLBufferPool::GLBufferPool(const GLContextRef & inCtx)	{
 GLBufferPool::~GLBufferPool()	{
 	//cout << __PRETTY_FUNCTION__ << endl;
 	
+	if (_asyncWorker != nullptr)	{
+		_asyncWorker->stop();
+		_asyncWorker = nullptr;
+	}
+	
+	//	every buffer retains its pool, so nothing else can be queued for deletion at this point
+	deleteQueuedResources();
+	
 	lock_guard<recursive_mutex>		lock(_contextLock);
 	if (_context != nullptr)	{
 		//delete _context;
@@ -69,6 +441,95 @@ GLBufferPool::~GLBufferPool()	{
 }
 
 
+//	returns the number of bytes a buffer occupies that will be released by the pool which created it (zero if the buffer's resources aren't owned by the pool)
+static size_t ResidentLengthForBuffer(const GLBuffer::Descriptor & inDesc, const Size & inSize)	{
+	//	these conditions mirror the logic in GLBuffer's destructor that determines whether or not the pool releases a buffer's resources
+	if (inDesc.gpuBackingType!=GLBuffer::Backing_Internal && !(inDesc.gpuBackingType==GLBuffer::Backing_None && inDesc.cpuBackingType==GLBuffer::Backing_Internal))
+		return 0;
+	switch (inDesc.type)	{
+	case GLBuffer::Type_CPU:
+	case GLBuffer::Type_RB:
+	case GLBuffer::Type_Tex:
+	case GLBuffer::Type_PBO:
+		return inDesc.backingLengthForSize(inSize);
+	case GLBuffer::Type_FBO:
+	case GLBuffer::Type_VBO:
+	case GLBuffer::Type_EBO:
+	case GLBuffer::Type_VAO:
+		break;
+	}
+	return 0;
+}
+
+
+
+
+//	returns false if the IOSurface-related aspects of a free buffer aren't consistent (in which case it can't be recycled)
+static inline bool FreeBufferIsRecyclable(const GLBuffer & n)	{
+#if defined(VVGL_SDK_MAC)
+	IOSurfaceRef		srf = n.localSurfaceRef();
+	if ((n.desc.localSurfaceID!=0 && srf==nullptr)	||
+	(n.desc.localSurfaceID==0 && srf!=nullptr))	{
+		return false;
+	}
+#else
+	(void)n;
+#endif
+	return true;
+}
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- free buffer index
+
+
+GLBufferPool::FreeBufferKey::FreeBufferKey(const GLBuffer::Descriptor & inDesc, const Size & inSize)	{
+	type = inDesc.type;
+	target = inDesc.target;
+	internalFormat = inDesc.internalFormat;
+	pixelFormat = inDesc.pixelFormat;
+	pixelType = inDesc.pixelType;
+	cpuBackingType = inDesc.cpuBackingType;
+	gpuBackingType = inDesc.gpuBackingType;
+	texRangeFlag = inDesc.texRangeFlag;
+	texClientStorageFlag = inDesc.texClientStorageFlag;
+	msAmount = inDesc.msAmount;
+	//	FBOs can be recycled regardless of their size
+	size = (type == GLBuffer::Type_FBO) ? Size(0,0) : inSize;
+}
+bool GLBufferPool::FreeBufferKey::operator==(const FreeBufferKey & n) const	{
+	return (type == n.type	&&
+	target == n.target	&&
+	internalFormat == n.internalFormat	&&
+	pixelFormat == n.pixelFormat	&&
+	pixelType == n.pixelType	&&
+	cpuBackingType == n.cpuBackingType	&&
+	gpuBackingType == n.gpuBackingType	&&
+	texRangeFlag == n.texRangeFlag	&&
+	texClientStorageFlag == n.texClientStorageFlag	&&
+	msAmount == n.msAmount	&&
+	size == n.size);
+}
+size_t GLBufferPool::FreeBufferKeyHash::operator()(const FreeBufferKey & n) const	{
+	size_t		returnMe = hash<double>()(n.size.width);
+	auto		combine = [&](const size_t & inVal)	{
+		returnMe ^= inVal + 0x9e3779b9 + (returnMe << 6) + (returnMe >> 2);
+	};
+	combine(hash<double>()(n.size.height));
+	combine(static_cast<size_t>(n.type));
+	combine(static_cast<size_t>(n.target));
+	combine(static_cast<size_t>(n.internalFormat));
+	combine(static_cast<size_t>(n.pixelFormat));
+	combine(static_cast<size_t>(n.pixelType));
+	combine(static_cast<size_t>(n.cpuBackingType) | (static_cast<size_t>(n.gpuBackingType) << 4));
+	combine(static_cast<size_t>(n.texRangeFlag) | (static_cast<size_t>(n.texClientStorageFlag) << 1));
+	combine(static_cast<size_t>(n.msAmount));
+	return returnMe;
+}
+
+
 /*	========================================	*/
 #pragma mark --------------------- public API
 
@@ -90,9 +551,30 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 	}
 	
 	//	...if i'm here then i couldn't find a free buffer, and i need to create one
+	return createNewBufferRef(d, s, b, bs, inCreateInCurrentContext);
+}
+GLBufferRef GLBufferPool::createNewBufferRef(const GLBuffer::Descriptor & d, const Size & s, const void * b, const Size & bs, const bool & inCreateInCurrentContext, const uint32_t & inName)	{
+	if (_deleted)
+		return nullptr;
+	
+	GLBufferRef		returnMe = nullptr;
+	
+	//	if the pool has a byte budget, make room for the new buffer by releasing the least-recently-used free buffers
+	size_t			residentLength = ResidentLengthForBuffer(d, s);
+	size_t			byteBudget = _byteBudget;
+	if (byteBudget > 0 && (_residentBytes+residentLength) > byteBudget)	{
+		//	buffers cached by other threads have to be in the shared free lists to be evicted
+		flushThreadCaches();
+		vector<unique_ptr<GLBuffer>>		evictedBuffers;
+		{
+			lock_guard<mutex>		lock(_freeBuffersLock);
+			evictedBuffers = evictFreeBuffersToFit(residentLength);
+		}
+		//	the evicted buffers release their resources as they fall out of scope, after the free buffer lock has been relinquished
+	}
 	
 	//	make the buffer
-	returnMe = make_shared<GLBuffer>();
+	returnMe = makeBufferRef(new GLBuffer());
 	//	copy the passed descriptor to the buffer i just created
 	GLBuffer::Descriptor 		&newBufferDesc = returnMe->desc;
 	newBufferDesc = d;
@@ -169,8 +651,12 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 	case GLBuffer::Type_CPU:
 		break;
 	case GLBuffer::Type_PBO:
-		glGenBuffers(1, &(returnMe->name));
-		GLERRLOG
+		if (inName != 0)
+			returnMe->name = inName;
+		else	{
+			glGenBuffers(1, &(returnMe->name));
+			GLERRLOG
+		}
 		if (!inCreateInCurrentContext)	{
 			//	flush!
 			glFlush();
@@ -179,8 +665,12 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 		break;
 	case GLBuffer::Type_RB:
 		//	generate the renderbuffer
-		glGenRenderbuffers(1, &(returnMe->name));
-		GLERRLOG
+		if (inName != 0)
+			returnMe->name = inName;
+		else	{
+			glGenRenderbuffers(1, &(returnMe->name));
+			GLERRLOG
+		}
 		//	bind the renderbuffer, set it up
 		glBindRenderbuffer(returnMe->desc.target, returnMe->name);
 		GLERRLOG
@@ -204,8 +694,12 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 		}
 		break;
 	case GLBuffer::Type_FBO:
-		glGenFramebuffers(1, &(returnMe->name));
-		GLERRLOG
+		if (inName != 0)
+			returnMe->name = inName;
+		else	{
+			glGenFramebuffers(1, &(returnMe->name));
+			GLERRLOG
+		}
 		if (!inCreateInCurrentContext)	{
 			glFlush();
 			GLERRLOG
@@ -243,8 +737,12 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 			GLERRLOG
 #endif
 		}
-		glGenTextures(1, &(returnMe->name));
-		GLERRLOG
+		if (inName != 0)
+			returnMe->name = inName;
+		else	{
+			glGenTextures(1, &(returnMe->name));
+			GLERRLOG
+		}
 		glBindTexture(newBufferDesc.target, returnMe->name);
 		GLERRLOG
 		
@@ -421,6 +919,10 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 	returnMe->backingSize = bs;
 	returnMe->cpuBackingPtr = const_cast<void*>(b);
 	
+	addResidentBytes(residentLength);
+	if (returnMe->name != 0)
+		++_stats.glObjectsCreated[d.type];
+	
 	//	timestamp the buffer!
 	timestampThisBuffer(returnMe);
 	
@@ -436,71 +938,292 @@ GLBufferRef GLBufferPool::createBufferRef(const GLBuffer::Descriptor & d, const
 }
 
 
+vector<GLBufferRef> GLBufferPool::createBufferRefs(const vector<pair<GLBuffer::Descriptor,Size>> & inRequests, const bool & inCreateInCurrentContext)	{
+	vector<GLBufferRef>		returnMe(inRequests.size(), nullptr);
+	if (_deleted)
+		return returnMe;
+	
+	//	recycle free buffers wherever we can, and make a note of the requests that need new buffers
+	vector<size_t>			newBufferIndexes;
+	for (size_t i=0; i<inRequests.size(); ++i)	{
+		//	buffers with CPU backings (and VBOs/EBOs/VAOs) have to be populated by their creation functions
+		const GLBuffer::Descriptor		&desc = inRequests[i].first;
+		switch (desc.type)	{
+		case GLBuffer::Type_RB:
+		case GLBuffer::Type_FBO:
+		case GLBuffer::Type_Tex:
+		case GLBuffer::Type_PBO:
+			break;
+		default:
+			continue;
+		}
+		if (desc.cpuBackingType != GLBuffer::Backing_None)
+			continue;
+		returnMe[i] = fetchMatchingFreeBuffer(inRequests[i].first, inRequests[i].second);
+		if (returnMe[i] == nullptr)
+			newBufferIndexes.push_back(i);
+	}
+	if (newBufferIndexes.size() < 1)
+		return returnMe;
+	
+	//	grab a context lock, and make the context current once for all of the buffers
+	lock_guard<recursive_mutex>		lock(_contextLock);
+	if (!inCreateInCurrentContext)	{
+		if (_context == nullptr)
+			return returnMe;
+		_context->makeCurrentIfNotCurrent();
+	}
+	
+	//	generate the names of all the GL resources we need with one call per type
+	vector<uint32_t>		texNames;
+	vector<uint32_t>		rbNames;
+	vector<uint32_t>		fboNames;
+	vector<uint32_t>		pboNames;
+	for (const auto & newBufferIndex : newBufferIndexes)	{
+		switch (inRequests[newBufferIndex].first.type)	{
+		case GLBuffer::Type_Tex:	texNames.push_back(0);	break;
+		case GLBuffer::Type_RB:		rbNames.push_back(0);	break;
+		case GLBuffer::Type_FBO:	fboNames.push_back(0);	break;
+		case GLBuffer::Type_PBO:	pboNames.push_back(0);	break;
+		default:	break;
+		}
+	}
+	if (texNames.size() > 0)	{
+		glGenTextures(static_cast<int>(texNames.size()), texNames.data());
+		GLERRLOG
+	}
+	if (rbNames.size() > 0)	{
+		glGenRenderbuffers(static_cast<int>(rbNames.size()), rbNames.data());
+		GLERRLOG
+	}
+	if (fboNames.size() > 0)	{
+		glGenFramebuffers(static_cast<int>(fboNames.size()), fboNames.data());
+		GLERRLOG
+	}
+	if (pboNames.size() > 0)	{
+		glGenBuffers(static_cast<int>(pboNames.size()), pboNames.data());
+		GLERRLOG
+	}
+	
+	//	set up each buffer in the (already current) context using the names we generated- this skips the per-buffer flush
+	auto		texNameIt = texNames.begin();
+	auto		rbNameIt = rbNames.begin();
+	auto		fboNameIt = fboNames.begin();
+	auto		pboNameIt = pboNames.begin();
+	for (const auto & newBufferIndex : newBufferIndexes)	{
+		const GLBuffer::Descriptor		&desc = inRequests[newBufferIndex].first;
+		uint32_t			name = 0;
+		switch (desc.type)	{
+		case GLBuffer::Type_Tex:	name = *(texNameIt++);	break;
+		case GLBuffer::Type_RB:		name = *(rbNameIt++);	break;
+		case GLBuffer::Type_FBO:	name = *(fboNameIt++);	break;
+		case GLBuffer::Type_PBO:	name = *(pboNameIt++);	break;
+		default:	break;
+		}
+		returnMe[newBufferIndex] = createNewBufferRef(desc, inRequests[newBufferIndex].second, nullptr, Size(), true, name);
+	}
+	
+	//	flush once for the whole batch
+	if (!inCreateInCurrentContext)	{
+		glFlush();
+		GLERRLOG
+	}
+	
+	return returnMe;
+}
+
+
 GLBufferRef GLBufferPool::fetchMatchingFreeBuffer(const GLBuffer::Descriptor & desc, const Size & size)	{
 	//cout << __PRETTY_FUNCTION__ << endl;
 	if (_deleted)
 		return nullptr;
 	
-	//	get a lock on the array of free buffers
-	lock_guard<mutex>		lock(_freeBuffersLock);
+	//	VBOs, EBOs, and VAOs are never recycled
+	switch (desc.type)	{
+	case GLBuffer::Type_VBO:
+	case GLBuffer::Type_EBO:
+	case GLBuffer::Type_VAO:
+		return nullptr;
+	default:
+		break;
+	}
+	
+	GLBuffer			*recycledBuffer = nullptr;
+	FreeBufferKey		key(desc, size);
+	
+	//	removes the most recently used matching buffer from the passed thread cache (caller must have a lock on the cache)
+	auto				takeFromCache = [&](ThreadCache & inCache)	{
+		vector<FreeBuffer>		&bufferList = inCache.buffers;
+		//	run through the list backwards- we want to recycle the most recently used buffer
+		for (auto it=bufferList.rbegin(); it!=bufferList.rend(); ++it)	{
+			if (!(FreeBufferKey(it->buffer->desc, it->buffer->size) == key) || !FreeBufferIsRecyclable(*(it->buffer)))
+				continue;
+			recycledBuffer = it->buffer.release();
+			bufferList.erase(next(it).base());
+			break;
+		}
+	};
 	
-	GLBufferRef			returnMe = nullptr;
+	//	first check this thread's cache- we don't need the shared lock for this
+	{
+		unique_lock<mutex>		lock;
+		takeFromCache(*threadCache(lock));
+	}
 	
-	vector<GLBufferRef>::iterator		it;
-	int						tmpIndex = 0;
-	for (it=_freeBuffers.begin(); it!=_freeBuffers.end(); ++it)	{
-		//	if this buffer is comparable to the passed descriptor and can be used for recycling...
-		GLBuffer			*bufferPtr = (*it).get();
-		if (bufferPtr->isComparableForRecycling(desc))	{
-			//	check to make sure that the dimensions of this buffer are compatible...
-			bool				sizeIsOK = false;
-			GLBuffer::Descriptor & desc = bufferPtr->desc;
-			//GLBuffer::Descriptor	*desc = &(bufferPtr->desc);
-			switch (desc.type)	{
-			case GLBuffer::Type_FBO:
-				sizeIsOK = true;
-				break;
-			case GLBuffer::Type_CPU:
-			case GLBuffer::Type_RB:
-			case GLBuffer::Type_Tex:
-			case GLBuffer::Type_PBO:
-				if (bufferPtr->size == size)
-					sizeIsOK = true;
-				break;
-			case GLBuffer::Type_VBO:
-			case GLBuffer::Type_EBO:
-			case GLBuffer::Type_VAO:
+	//	if this thread didn't have a matching buffer, check the shared free lists
+	if (recycledBuffer == nullptr)	{
+		lock_guard<mutex>		lock(_freeBuffersLock);
+		
+		//	find the list of free buffers that are comparable to the passed descriptor and size
+		auto				listIt = _freeBuffers.find(key);
+		if (listIt != _freeBuffers.end())	{
+			vector<FreeBuffer>		&bufferList = listIt->second;
+			//	run through the list backwards- we want to recycle the most recently used buffer
+			for (auto it=bufferList.rbegin(); it!=bufferList.rend(); ++it)	{
+				if (!FreeBufferIsRecyclable(*(it->buffer)))
+					continue;
+				//	if i'm here, this buffer is a match and i want to use it
+				recycledBuffer = it->buffer.release();
+				//	remove the buffer from the list
+				bufferList.erase(next(it).base());
 				break;
 			}
-			
-			//	if the size of this buffer is compatible with what's requested...
-			if (sizeIsOK)	{
-#if defined(VVGL_SDK_MAC)
-				//	check to make sure that the IOSurface-related aspects of this buffer are compatible
-				IOSurfaceRef		srf = bufferPtr->localSurfaceRef();
-				if ((desc.localSurfaceID!=0 && srf!=nullptr)	||
-				(desc.localSurfaceID==0 && srf==nullptr))	{
-#endif
-					//	if i'm here, this buffer is a match and i want to use it
-					returnMe = *it;
-					//	remove the buffer from the array
-					_freeBuffers.erase(_freeBuffers.begin()+tmpIndex);
-					//	reset the idleCount to 0 so it's "fresh" (so it gets returned to the pool when it's no longer needed)
-					(*returnMe).idleCount = 0;
-					//	break out of the for loop
-					break;
-#if defined(VVGL_SDK_MAC)
-				}
-#endif
-			}
 		}
-		++tmpIndex;
 	}
 	
+	//	buffers released on other threads stay in their caches until a cache fills up or housekeeping() flushes it- we don't look in other threads' caches, so a fetch never contends with them
+	
+	if (recycledBuffer == nullptr)	{
+		++_stats.fetchMisses[desc.type];
+		return nullptr;
+	}
+	++_stats.fetchHits[desc.type];
+	
+	_freeBytes -= ResidentLengthForBuffer(recycledBuffer->desc, recycledBuffer->size);
+	//	reset the idleCount to 0 so it's "fresh" (so it gets returned to the pool when it's no longer needed)
+	recycledBuffer->idleCount = 0;
+	
+	GLBufferRef			returnMe = makeBufferRef(recycledBuffer);
 	//	timestamp the buffer
-	if (returnMe != nullptr)
-		timestampThisBuffer(returnMe);
+	timestampThisBuffer(returnMe);
+	
+	return returnMe;
+}
+
+std::shared_future<GLBufferRef> GLBufferPool::createBufferRefAsync(const GLBuffer::Descriptor & desc, const Size & size)	{
+	//	this returns a future that's already been fulfilled with the passed buffer
+	auto		readyFuture = [](const GLBufferRef & n)	{
+		promise<GLBufferRef>		tmpPromise;
+		tmpPromise.set_value(n);
+		return tmpPromise.get_future().share();
+	};
+	
+	if (_deleted)
+		return readyFuture(nullptr);
+	
+	//	buffers with CPU backings are allocated by the buffer creation functions, and VBOs/EBOs/VAOs are populated when they're created
+	switch (desc.type)	{
+	case GLBuffer::Type_RB:
+	case GLBuffer::Type_FBO:
+	case GLBuffer::Type_Tex:
+		break;
+	default:
+		return readyFuture(nullptr);
+	}
+	if (desc.cpuBackingType != GLBuffer::Backing_None || desc.gpuBackingType != GLBuffer::Backing_Internal)
+		return readyFuture(nullptr);
+	
+	GLBufferPoolRef		selfRef = shared_from_this();
+	
+	//	if there's a free buffer we can use, we don't need the worker
+	GLBufferRef			freeBuffer = fetchMatchingFreeBuffer(desc, size);
+	if (freeBuffer != nullptr)	{
+		freeBuffer->parentBufferPool = selfRef;
+		return readyFuture(freeBuffer);
+	}
+	
+#if defined(VVGL_SDK_QT)
+	//	Qt contexts can only be used on the thread that owns them
+	GLBufferRef			newBuffer = createBufferRef(desc, size);
+	if (newBuffer != nullptr)
+		newBuffer->parentBufferPool = selfRef;
+	return readyFuture(newBuffer);
+#else
+	shared_ptr<AsyncWorker>		worker = nullptr;
+	{
+		lock_guard<recursive_mutex>		lock(_contextLock);
+		if (_context == nullptr)
+			return readyFuture(nullptr);
+		if (_asyncWorker == nullptr)	{
+			GLContextRef		workerCtx = _context->newContextSharingMe();
+			if (workerCtx == nullptr)
+				return readyFuture(nullptr);
+			_context->makeCurrentIfNotCurrent();
+			_asyncWorker = make_shared<AsyncWorker>(workerCtx);
+			_asyncWorker->start(_asyncWorker);
+		}
+		worker = _asyncWorker;
+	}
+	
+	AsyncWorker::Request		newRequest;
+	newRequest.desc = desc;
+	newRequest.size = size;
+	newRequest.pool = selfRef;
+	std::shared_future<GLBufferRef>		returnMe = newRequest.result.get_future().share();
+	worker->addRequest(move(newRequest));
+	return returnMe;
+#endif
+}
+
+size_t GLBufferPool::reserve(const GLBuffer::Descriptor & desc, const Size & size, const size_t & count, const bool & inCreateInCurrentContext)	{
+	if (_deleted || count == 0)
+		return 0;
+	
+	//	only buffers that consist entirely of GL resources the pool creates itself can be reserved (CPU backings are allocated by the buffer creation functions)
+	switch (desc.type)	{
+	case GLBuffer::Type_RB:
+	case GLBuffer::Type_FBO:
+	case GLBuffer::Type_Tex:
+		break;
+	default:
+		return 0;
+	}
+	if (desc.cpuBackingType != GLBuffer::Backing_None || desc.gpuBackingType != GLBuffer::Backing_Internal)
+		return 0;
+	
+	//	buffers cached by any thread count towards the reservation- moving them to the shared free lists lets us count them in one place
+	flushThreadCaches();
+	FreeBufferKey		key(desc, size);
+	size_t				freeCount = 0;
+	{
+		lock_guard<mutex>		lock(_freeBuffersLock);
+		auto				listIt = _freeBuffers.find(key);
+		if (listIt != _freeBuffers.end())	{
+			for (const auto & freeBuffer : listIt->second)	{
+				if (FreeBufferIsRecyclable(*(freeBuffer.buffer)))
+					++freeCount;
+			}
+		}
+	}
+	if (freeCount >= count)
+		return 0;
+	
+	//	create the missing buffers- they're all retained until we're done, or we'd just keep recycling the first one
+	GLBufferPoolRef				selfRef = shared_from_this();
+	vector<GLBufferRef>			newBuffers;
+	newBuffers.reserve(count - freeCount);
+	for (size_t i=freeCount; i<count; ++i)	{
+		GLBufferRef			newBuffer = createNewBufferRef(desc, size, nullptr, Size(), inCreateInCurrentContext);
+		if (newBuffer == nullptr)
+			break;
+		newBuffer->parentBufferPool = selfRef;
+		newBuffers.push_back(newBuffer);
+	}
 	
+	//	return the new buffers to the pool- they land in this thread's cache, so move them to the shared free lists where every thread (e.g. a render thread, if we're reserving from a UI thread) can find them
+	size_t				returnMe = newBuffers.size();
+	newBuffers.clear();
+	flushThreadCaches();
 	return returnMe;
 }
 
@@ -508,32 +1231,121 @@ void GLBufferPool::housekeeping()	{
 	//cout << __PRETTY_FUNCTION__ << endl;
 	//cout << "\tthis is " << this << endl;
 	
-	lock_guard<mutex>		lock(_freeBuffersLock);
-	
-	bool			needsToClearStuff = false;
-	for_each(_freeBuffers.begin(), _freeBuffers.end(), [&](const GLBufferRef & n)	{
-		(*n).idleCount++;
-		if ((*n).idleCount >= IDLEBUFFERCOUNT)
-			needsToClearStuff = true;
-	});
-	
-	//	if there are indices that need to be removed...
-	if (needsToClearStuff)	{
-		auto		removeIt = remove_if(_freeBuffers.begin(), _freeBuffers.end(), [&](GLBufferRef n){ return (*n).idleCount >= IDLEBUFFERCOUNT; });
-		_freeBuffers.erase(removeIt, _freeBuffers.end());
+	{
+		//	the buffers we remove from the pool are released when this falls out of scope (after the free buffer locks have been relinquished)
+		vector<unique_ptr<GLBuffer>>		expiredBuffers;
+		
+		//	move the buffers cached by each thread to the shared free lists, so they're visible to every thread (and expire normally)
+		flushThreadCaches();
+		
+		//	if there's a byte budget, free buffers aren't expired by idle count- instead, we release the least-recently-used buffers until we're within budget
+		if (_byteBudget > 0)	{
+			lock_guard<mutex>		lock(_freeBuffersLock);
+			expiredBuffers = evictFreeBuffersToFit(0);
+		}
+		else	{
+			//	this increments the idle count of every buffer in the passed list, and moves the buffers that have been idle for too long to 'expiredBuffers'
+			auto		expireBuffersInList = [&](vector<FreeBuffer> & bufferList)	{
+				for_each(bufferList.begin(), bufferList.end(), [&](const FreeBuffer & n)	{
+					(*n.buffer).idleCount++;
+				});
+				//	buffers are stored in the order they were returned to the pool, so any buffers that have been idle for too long are at the front of the list
+				auto		keepIt = find_if(bufferList.begin(), bufferList.end(), [&](const FreeBuffer & n){ return (*n.buffer).idleCount < IDLEBUFFERCOUNT; });
+				for_each(bufferList.begin(), keepIt, [&](FreeBuffer & n)	{
+					_freeBytes -= ResidentLengthForBuffer(n.buffer->desc, n.buffer->size);
+					expiredBuffers.push_back(move(n.buffer));
+					++_stats.evictions;
+				});
+				bufferList.erase(bufferList.begin(), keepIt);
+			};
+			
+			lock_guard<mutex>		lock(_freeBuffersLock);
+			for (auto & listIt : _freeBuffers)	{
+				expireBuffersInList(listIt.second);
+			}
+		}
 	}
+	
+	//	the expired buffers queued their GL resources for deletion as they were freed- delete them (and anything else that was released since the last housekeeping) now
+	deleteQueuedResources();
 }
 void GLBufferPool::purge()	{
+	vector<unique_ptr<GLBuffer>>		expiredBuffers;
+	
+	auto		expireAllBuffersInList = [&](vector<FreeBuffer> & bufferList)	{
+		for_each(bufferList.begin(), bufferList.end(), [&](FreeBuffer & n)	{
+			_freeBytes -= ResidentLengthForBuffer(n.buffer->desc, n.buffer->size);
+			//	a non-zero idle count ensures the buffer's resources are released (instead of returned to the pool) when it's freed
+			n.buffer->idleCount = (IDLEBUFFERCOUNT+1);
+			expiredBuffers.push_back(move(n.buffer));
+		});
+		bufferList.clear();
+	};
+	
+	{
+		lock_guard<mutex>		cachesLock(_threadCachesLock);
+		for (auto & cacheIt : _threadCaches)	{
+			lock_guard<mutex>		lock(cacheIt.second->lock);
+			expireAllBuffersInList(cacheIt.second->buffers);
+		}
+	}
+	
 	{
 		lock_guard<mutex>		lock(_freeBuffersLock);
-		for_each(_freeBuffers.begin(), _freeBuffers.end(), [&](const GLBufferRef & n)	{
-			n->idleCount = (IDLEBUFFERCOUNT+1);
-		});
+		for (auto & listIt : _freeBuffers)	{
+			expireAllBuffersInList(listIt.second);
+		}
+		_freeBuffers.clear();
+	}
+	
+	//	release the expired buffers, then delete their GL resources
+	expiredBuffers.clear();
+	deleteQueuedResources();
+	
+	GLCPUBackingAllocatorRef		allocator = cpuBackingAllocator();
+	if (allocator != nullptr)
+		allocator->purge();
+}
+void GLBufferPool::setByteBudget(const size_t & n)	{
+	vector<unique_ptr<GLBuffer>>		expiredBuffers;
+	
+	_byteBudget = n;
+	if (n > 0)	{
+		flushThreadCaches();
+		lock_guard<mutex>		lock(_freeBuffersLock);
+		expiredBuffers = evictFreeBuffersToFit(0);
 	}
-	housekeeping();
+}
+void GLBufferPool::setCPUBackingAllocator(const GLCPUBackingAllocatorRef & n)	{
+	GLCPUBackingAllocatorRef		newAllocator = (n==nullptr) ? make_shared<GLPooledCPUBackingAllocator>() : n;
+	atomic_store(&_cpuBackingAllocator, newAllocator);
+}
+GLCPUBackingAllocatorRef GLBufferPool::cpuBackingAllocator() const	{
+	return atomic_load(&_cpuBackingAllocator);
+}
+GLBufferPool::Stats GLBufferPool::stats() const	{
+	Stats			returnMe;
+	for (int i=0; i<=GLBuffer::Type_VAO; ++i)	{
+		returnMe.fetchHits[i] = _stats.fetchHits[i];
+		returnMe.fetchMisses[i] = _stats.fetchMisses[i];
+		returnMe.glObjectsCreated[i] = _stats.glObjectsCreated[i];
+		returnMe.glObjectsDestroyed[i] = _stats.glObjectsDestroyed[i];
+	}
+	returnMe.evictions = _stats.evictions;
+	returnMe.freeBytes = _freeBytes;
+	returnMe.residentBytes = _residentBytes;
+	//	the free and resident byte counts are updated independently, so the free count may briefly be larger
+	returnMe.liveBytes = (returnMe.residentBytes > returnMe.freeBytes) ? returnMe.residentBytes - returnMe.freeBytes : 0;
+	returnMe.peakResidentBytes = _peakResidentBytes;
+	return returnMe;
+}
+void GLBufferPool::resetStats()	{
+	_stats.reset();
+	resetPeakResidentBytes();
 }
 ostream & operator<<(ostream & os, const GLBufferPool & n)	{
-	os << "<GLBufferPool " << &n << ">";
+	GLBufferPool::Stats		tmpStats = n.stats();
+	os << "<GLBufferPool " << &n << ", " << tmpStats.residentBytes << " bytes resident (" << tmpStats.freeBytes << " free), hit rate " << tmpStats.hitRate() << ">";
 	return os;
 }
 
@@ -566,15 +1378,10 @@ void GLBufferPool::returnBufferToPool(GLBuffer * inBuffer)	{
 		return;
 	}
 	
-	//	get a lock for the _freeBuffers array
-	lock_guard<mutex>		lock(_freeBuffersLock);
-	
-	//	if '_freeBuffers' is at capacity, increase its capacity
-	if (_freeBuffers.size() == _freeBuffers.capacity())
-		_freeBuffers.reserve(_freeBuffers.capacity()+25);
-	
-	//	make a shared ptr for the passed buffer, stick it in the vector
-	_freeBuffers.emplace_back(make_shared<GLBuffer>(*inBuffer));
+	//	the passed buffer is being deallocated, so we have to make a copy of it to put in the pool
+	FreeBuffer			newFreeBuffer;
+	newFreeBuffer.buffer = unique_ptr<GLBuffer>(new GLBuffer(*inBuffer));
+	addToThreadCache(move(newFreeBuffer));
 	
 	//	now clear out some vars in the passed buffer- we don't want to release a backing if we're putting it back in the pool
 	inBuffer->backingReleaseCallback = nullptr;
@@ -582,81 +1389,402 @@ void GLBufferPool::returnBufferToPool(GLBuffer * inBuffer)	{
 	
 }
 
+bool GLBufferPool::recycleBuffer(GLBuffer * inBuffer)	{
+	if (inBuffer == nullptr || _deleted)
+		return false;
+	
+	//	these conditions mirror the logic in GLBuffer's destructor that determines whether or not a buffer is returned to the pool
+	GLBuffer::Descriptor	&desc = inBuffer->desc;
+	if (inBuffer->copySourceBuffer != nullptr	||
+	desc.cpuBackingType == GLBuffer::Backing_External	||
+	(desc.gpuBackingType != GLBuffer::Backing_Internal && desc.gpuBackingType != GLBuffer::Backing_None)	||
+	inBuffer->idleCount != 0	||
+	inBuffer->preferDeletion)	{
+		return false;
+	}
+	
+	//	the pool takes ownership of the buffer (and its backing)- all we have to do is release anything it was retaining for its owner
+	inBuffer->associatedBuffer = nullptr;
+	
+	FreeBuffer			newFreeBuffer;
+	newFreeBuffer.buffer = unique_ptr<GLBuffer>(inBuffer);
+	addToThreadCache(move(newFreeBuffer));
+	return true;
+}
+
+void GLBufferPool::addToThreadCache(FreeBuffer && inBuffer)	{
+	inBuffer.returnIndex = ++_returnCount;
+	_freeBytes += ResidentLengthForBuffer(inBuffer.buffer->desc, inBuffer.buffer->size);
+	
+	//	stick it at the end of this thread's cache- if the cache is full, move the oldest half of it to the shared free lists
+	unique_lock<mutex>		lock;
+	ThreadCache			*cache = threadCache(lock);
+	vector<FreeBuffer>		&bufferList = cache->buffers;
+	bufferList.emplace_back(move(inBuffer));
+	if (bufferList.size() > THREADCACHESIZE)	{
+		auto				flushEnd = bufferList.begin() + (bufferList.size()/2);
+		{
+			lock_guard<mutex>		sharedLock(_freeBuffersLock);
+			addToFreeBuffers(bufferList.begin(), flushEnd);
+		}
+		bufferList.erase(bufferList.begin(), flushEnd);
+	}
+}
+
+GLBufferRef GLBufferPool::makeBufferRef(GLBuffer * inBuffer)	{
+	//	the control block is allocated from a node pool, so recycling a buffer doesn't allocate any memory
+	return GLBufferRef(inBuffer, RecyclingDeleter(), GLBufferRefAllocator<GLBuffer>());
+}
+
+void GLBufferPool::RecyclingDeleter::operator()(GLBuffer * n) const	{
+	if (n == nullptr)
+		return;
+	//	if the pool doesn't take the buffer, delete it- its destructor releases its resources
+	GLBufferPool		*pool = n->parentBufferPool.get();
+	if (pool==nullptr || !pool->recycleBuffer(n))
+		delete n;
+}
+
 void GLBufferPool::releaseBufferResources(GLBuffer * inBuffer)	{
 	//cout << __PRETTY_FUNCTION__ << "... " << *inBuffer << endl;
 	
 	if (inBuffer == nullptr)
 		return;
 	
+	//	GL resources that aren't tied to memory that's about to be freed don't have to be deleted right away- queue them, and housekeeping() deletes them in batches.  this doesn't require the GL context or any locks.
+	GLBuffer::Descriptor	&desc = inBuffer->desc;
+	if (!desc.texRangeFlag && !desc.texClientStorageFlag && !inBuffer->pboMapped)	{
+		subtractResidentBytes(ResidentLengthForBuffer(desc, inBuffer->size));
+		if (desc.type != GLBuffer::Type_CPU && inBuffer->name != 0)
+			queueDeletion(desc.type, inBuffer->name);
+		return;
+	}
+	
 	lock_guard<recursive_mutex>		lock(_contextLock);
 	if (_context == nullptr)
 		return;
 	
 	//	Qt has thread-specific contexts: you cannot make them current on any other threads or they crash
 #if defined(VVGL_SDK_QT)
-	//	if we can't make the context current on this thread
+	//	if we can't make the context current on this thread
+	QThread			*currentThread = QThread::currentThread();
+	QObject			*qCtxAsObj = (QObject*)_context->context();
+	QThread			*ctxThread = (qCtxAsObj==nullptr) ? nullptr : qCtxAsObj->thread();
+	
+	if (currentThread != ctxThread)	{
+		//cout << "\terr: can't release buffer " << inBuffer->getDescriptionString() << " on this thread..." << endl;
+		//	make a new GLBuffer that duplicates the GLBuffer we were passed (which is being freed)
+		GLBuffer		*copiedBuffer = inBuffer->allocShallowCopy();
+		//	now we want this buffer to get deleted on the context's thread...
+		perform_async([=](){
+			//cout << "\tshould be deleting the copied buffer now..." << endl;
+			delete copiedBuffer;
+		}, qCtxAsObj);
+		//	return- we can't make the context current or delete anything on this thread
+		return;
+	}
+#endif	//	VVGL_SDK_QT
+	
+	//_context->makeCurrentIfNull();
+	//_context->makeCurrent();
+	_context->makeCurrentIfNotCurrent();
+	
+	subtractResidentBytes(ResidentLengthForBuffer(inBuffer->desc, inBuffer->size));
+	
+	switch (inBuffer->desc.type)	{
+	case GLBuffer::Type_CPU:
+		break;
+	case GLBuffer::Type_RB:
+		glDeleteRenderbuffers(1, &inBuffer->name);
+		GLERRLOG
+		++_stats.glObjectsDestroyed[inBuffer->desc.type];
+		break;
+	case GLBuffer::Type_FBO:
+		glDeleteFramebuffers(1, &inBuffer->name);
+		GLERRLOG
+		++_stats.glObjectsDestroyed[inBuffer->desc.type];
+		break;
+	case GLBuffer::Type_Tex:
+		glDeleteTextures(1, &inBuffer->name);
+		GLERRLOG
+		++_stats.glObjectsDestroyed[inBuffer->desc.type];
+		break;
+	case GLBuffer::Type_PBO:
+//	PBOs aren't available in ES 2
+#if !defined(VVGL_TARGETENV_GLES)
+		if (inBuffer->pboMapped)	{
+			inBuffer->unmapPBO(true);
+		}
+#endif	//	!defined(VVGL_TARGETENV_GLES)
+		glDeleteBuffers(1, &inBuffer->name);
+		GLERRLOG
+		++_stats.glObjectsDestroyed[inBuffer->desc.type];
+		break;
+	case GLBuffer::Type_VBO:
+		glDeleteBuffers(1, &inBuffer->name);
+		GLERRLOG
+		break;
+	case GLBuffer::Type_EBO:
+		glDeleteBuffers(1, &inBuffer->name);
+		GLERRLOG
+		break;
+	case GLBuffer::Type_VAO:
+		glDeleteVertexArrays(1, &inBuffer->name);
+		GLERRLOG
+		break;
+	}
+	glFlush();
+	GLERRLOG
+}
+
+
+
+
+void GLBufferPool::queueDeletion(const GLBuffer::Type & inType, const uint32_t & inName)	{
+	QueuedDeletion		*newNode = new QueuedDeletion;
+	newNode->type = inType;
+	newNode->name = inName;
+	newNode->next = _deletionQueue.load();
+	//	if another thread pushed onto the queue first, 'newNode->next' is updated and we try again
+	while (!_deletionQueue.compare_exchange_weak(newNode->next, newNode))	{
+	}
+}
+void GLBufferPool::deleteQueuedResources()	{
+	//	take the whole queue at once- other threads can keep pushing onto the (now empty) queue while we delete its contents
+	QueuedDeletion		*node = _deletionQueue.exchange(nullptr);
+	if (node == nullptr)
+		return;
+	
+	//	sort the GL resources by type, so each type can be deleted with a single call
+	struct DeletionBatch	{
+		vector<uint32_t>		textures;
+		vector<uint32_t>		renderbuffers;
+		vector<uint32_t>		framebuffers;
+		vector<uint32_t>		buffers;
+		vector<uint32_t>		vertexArrays;
+		
+		void deleteResources() const	{
+			if (textures.size() > 0)	{
+				glDeleteTextures(static_cast<int>(textures.size()), textures.data());
+				GLERRLOG
+			}
+			if (renderbuffers.size() > 0)	{
+				glDeleteRenderbuffers(static_cast<int>(renderbuffers.size()), renderbuffers.data());
+				GLERRLOG
+			}
+			if (framebuffers.size() > 0)	{
+				glDeleteFramebuffers(static_cast<int>(framebuffers.size()), framebuffers.data());
+				GLERRLOG
+			}
+			if (buffers.size() > 0)	{
+				glDeleteBuffers(static_cast<int>(buffers.size()), buffers.data());
+				GLERRLOG
+			}
+			if (vertexArrays.size() > 0)	{
+				glDeleteVertexArrays(static_cast<int>(vertexArrays.size()), vertexArrays.data());
+				GLERRLOG
+			}
+			glFlush();
+			GLERRLOG
+		}
+	};
+	DeletionBatch		batch;
+	while (node != nullptr)	{
+		switch (node->type)	{
+		case GLBuffer::Type_CPU:
+			break;
+		case GLBuffer::Type_RB:
+			batch.renderbuffers.push_back(node->name);
+			++_stats.glObjectsDestroyed[node->type];
+			break;
+		case GLBuffer::Type_FBO:
+			batch.framebuffers.push_back(node->name);
+			++_stats.glObjectsDestroyed[node->type];
+			break;
+		case GLBuffer::Type_Tex:
+			batch.textures.push_back(node->name);
+			++_stats.glObjectsDestroyed[node->type];
+			break;
+		case GLBuffer::Type_PBO:
+			batch.buffers.push_back(node->name);
+			++_stats.glObjectsDestroyed[node->type];
+			break;
+		case GLBuffer::Type_VBO:
+		case GLBuffer::Type_EBO:
+			batch.buffers.push_back(node->name);
+			break;
+		case GLBuffer::Type_VAO:
+			batch.vertexArrays.push_back(node->name);
+			break;
+		}
+		QueuedDeletion		*nextNode = node->next;
+		delete node;
+		node = nextNode;
+	}
+	
+	lock_guard<recursive_mutex>		lock(_contextLock);
+	if (_context == nullptr)
+		return;
+	
+	//	Qt has thread-specific contexts: if we can't make the context current on this thread, delete the whole batch on the context's thread
+#if defined(VVGL_SDK_QT)
 	QThread			*currentThread = QThread::currentThread();
 	QObject			*qCtxAsObj = (QObject*)_context->context();
 	QThread			*ctxThread = (qCtxAsObj==nullptr) ? nullptr : qCtxAsObj->thread();
 	
 	if (currentThread != ctxThread)	{
-		//cout << "\terr: can't release buffer " << inBuffer->getDescriptionString() << " on this thread..." << endl;
-		//	make a new GLBuffer that duplicates the GLBuffer we were passed (which is being freed)
-		GLBuffer		*copiedBuffer = inBuffer->allocShallowCopy();
-		//	now we want this buffer to get deleted on the context's thread...
+		//	the lambda retains the context (not the pool, which may be freed before it executes)
+		GLContextRef		ctx = _context;
 		perform_async([=](){
-			//cout << "\tshould be deleting the copied buffer now..." << endl;
-			delete copiedBuffer;
+			ctx->makeCurrentIfNotCurrent();
+			batch.deleteResources();
 		}, qCtxAsObj);
-		//	return- we can't make the context current or delete anything on this thread
 		return;
 	}
 #endif	//	VVGL_SDK_QT
 	
-	//_context->makeCurrentIfNull();
-	//_context->makeCurrent();
 	_context->makeCurrentIfNotCurrent();
+	batch.deleteResources();
+}
+
+
+
+
+GLBufferPool::ThreadCache * GLBufferPool::threadCache(unique_lock<mutex> & outLock)	{
+	//	each thread remembers its caches, so it doesn't have to take '_threadCachesLock' to find them.  a cache stays registered with its pool for as long as its thread is running, so the raw pointer is valid whenever the pool is.  when the thread exits, its caches are marked so their pools can stop tracking them.
+	struct ThreadCaches	{
+		struct Entry	{
+			uint64_t				poolID;
+			ThreadCache				*cache;
+			weak_ptr<ThreadCache>	cacheRef;
+		};
+		vector<Entry>		entries;
+		~ThreadCaches()	{
+			for (Entry & entry : entries)	{
+				shared_ptr<ThreadCache>		cache = entry.cacheRef.lock();
+				if (cache != nullptr)
+					cache->threadExited = true;
+			}
+		}
+	};
+	static thread_local ThreadCaches		threadCaches;
 	
-	switch (inBuffer->desc.type)	{
-	case GLBuffer::Type_CPU:
-		break;
-	case GLBuffer::Type_RB:
-		glDeleteRenderbuffers(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_FBO:
-		glDeleteFramebuffers(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_Tex:
-		glDeleteTextures(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_PBO:
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
-		if (inBuffer->pboMapped)	{
-			inBuffer->unmapPBO(true);
+	ThreadCache			*returnMe = nullptr;
+	for (const ThreadCaches::Entry & entry : threadCaches.entries)	{
+		if (entry.poolID == _poolID)	{
+			returnMe = entry.cache;
+			break;
 		}
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
-		glDeleteBuffers(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_VBO:
-		glDeleteBuffers(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_EBO:
-		glDeleteBuffers(1, &inBuffer->name);
-		GLERRLOG
-		break;
-	case GLBuffer::Type_VAO:
-		glDeleteVertexArrays(1, &inBuffer->name);
-		GLERRLOG
-		break;
 	}
-	glFlush();
-	GLERRLOG
+	if (returnMe == nullptr)	{
+		shared_ptr<ThreadCache>		newCache = make_shared<ThreadCache>();
+		newCache->buffers.reserve(THREADCACHESIZE+1);
+		{
+			lock_guard<mutex>		lock(_threadCachesLock);
+			shared_ptr<ThreadCache>		&cachePtr = _threadCaches[this_thread::get_id()];
+			//	a thread that exited may have had this thread's ID- move anything left in its cache to the shared free lists before we replace it
+			if (cachePtr != nullptr)	{
+				lock_guard<mutex>		cacheLock(cachePtr->lock);
+				if (cachePtr->buffers.size() > 0)	{
+					lock_guard<mutex>		sharedLock(_freeBuffersLock);
+					addToFreeBuffers(cachePtr->buffers.begin(), cachePtr->buffers.end());
+				}
+				cachePtr->buffers.clear();
+			}
+			cachePtr = newCache;
+		}
+		//	forget the caches of pools that have been freed
+		auto				expiredIt = remove_if(threadCaches.entries.begin(), threadCaches.entries.end(), [](const ThreadCaches::Entry & n){ return n.cacheRef.expired(); });
+		threadCaches.entries.erase(expiredIt, threadCaches.entries.end());
+		threadCaches.entries.push_back({ _poolID, newCache.get(), newCache });
+		returnMe = newCache.get();
+	}
+	
+	outLock = unique_lock<mutex>(returnMe->lock);
+	return returnMe;
+}
+void GLBufferPool::flushThreadCaches()	{
+	lock_guard<mutex>		cachesLock(_threadCachesLock);
+	for (auto cacheIt=_threadCaches.begin(); cacheIt!=_threadCaches.end(); )	{
+		bool			threadExited = false;
+		{
+			lock_guard<mutex>		lock(cacheIt->second->lock);
+			vector<FreeBuffer>		&bufferList = cacheIt->second->buffers;
+			if (bufferList.size() > 0)	{
+				lock_guard<mutex>		sharedLock(_freeBuffersLock);
+				addToFreeBuffers(bufferList.begin(), bufferList.end());
+			}
+			//	clearing the list keeps its storage, so the cache doesn't allocate when it's refilled
+			bufferList.clear();
+			threadExited = cacheIt->second->threadExited;
+		}
+		//	the caches of running threads stay registered- only the caches of threads that have exited are dropped
+		if (threadExited)
+			cacheIt = _threadCaches.erase(cacheIt);
+		else
+			++cacheIt;
+	}
+}
+void GLBufferPool::addToFreeBuffers(const vector<FreeBuffer>::iterator & inBegin, const vector<FreeBuffer>::iterator & inEnd)	{
+	//	this method assumes that the caller has a lock on '_freeBuffersLock'!
+	for (auto it=inBegin; it!=inEnd; ++it)	{
+		vector<FreeBuffer>		&bufferList = _freeBuffers[FreeBufferKey(it->buffer->desc, it->buffer->size)];
+		//	the lists have to stay ordered by return index (other threads may have flushed more recently-returned buffers already)
+		auto				insertIt = bufferList.end();
+		while (insertIt!=bufferList.begin() && prev(insertIt)->returnIndex > it->returnIndex)
+			--insertIt;
+		bufferList.insert(insertIt, move(*it));
+	}
+}
+vector<unique_ptr<GLBuffer>> GLBufferPool::evictFreeBuffersToFit(const size_t & inBytesNeeded)	{
+	//	this method assumes that the caller has a lock on '_freeBuffersLock'!
+	vector<unique_ptr<GLBuffer>>		returnMe;
+	//	the budget may be changed by another thread, so we read it once
+	size_t				byteBudget = _byteBudget;
+	if (byteBudget == 0)
+		return returnMe;
+	
+	size_t				projectedBytes = _residentBytes + inBytesNeeded;
+	while (projectedBytes > byteBudget)	{
+		//	each list is ordered from least- to most-recently used, so the least-recently-used free buffer is at the front of one of the lists
+		vector<FreeBuffer>		*lruList = nullptr;
+		for (auto & listIt : _freeBuffers)	{
+			vector<FreeBuffer>		&bufferList = listIt.second;
+			if (bufferList.size() < 1)
+				continue;
+			if (lruList==nullptr || bufferList.front().returnIndex < lruList->front().returnIndex)
+				lruList = &bufferList;
+		}
+		//	if there aren't any free buffers left then there's nothing more we can release
+		if (lruList == nullptr)
+			break;
+		
+		unique_ptr<GLBuffer>		evictMe = move(lruList->front().buffer);
+		lruList->erase(lruList->begin());
+		
+		size_t				evictedLength = ResidentLengthForBuffer(evictMe->desc, evictMe->size);
+		_freeBytes -= evictedLength;
+		projectedBytes = (projectedBytes > evictedLength) ? projectedBytes - evictedLength : 0;
+		//	a non-zero idle count ensures the buffer's resources are released (instead of returned to the pool) when it's freed
+		evictMe->idleCount = (IDLEBUFFERCOUNT+1);
+		returnMe.push_back(move(evictMe));
+		++_stats.evictions;
+	}
+	return returnMe;
+}
+
+void GLBufferPool::addResidentBytes(const size_t & n)	{
+	if (n == 0)
+		return;
+	size_t			newResidentBytes = (_residentBytes += n);
+	size_t			peakBytes = _peakResidentBytes;
+	while (newResidentBytes > peakBytes && !_peakResidentBytes.compare_exchange_weak(peakBytes, newResidentBytes))	{
+	}
+}
+void GLBufferPool::subtractResidentBytes(const size_t & n)	{
+	if (n == 0)
+		return;
+	_residentBytes -= n;
 }
 
 
@@ -966,13 +2094,21 @@ GLBufferRef CreateRGBACPUBuffer(const Size & size, const GLBufferPoolRef & inPoo
 	
 	GLBufferRef		returnMe = inPoolRef->fetchMatchingFreeBuffer(desc, size);
 	if (returnMe == nullptr)	{
-		void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+		size_t			bufferLength = desc.backingLengthForSize(size);
+		GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+		void			*bufferMemory = allocator->allocate(bufferLength);
+		if (bufferMemory == nullptr)
+			return nullptr;
 		returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, false);
+		if (returnMe == nullptr)	{
+			allocator->release(bufferMemory, bufferLength);
+			return nullptr;
+		}
 		returnMe->parentBufferPool = inPoolRef;
 		returnMe->backingID = GLBuffer::BackingID_Pixels;
 		returnMe->backingContext = bufferMemory;
-		returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-			free(inReleaseContext);
+		returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+			allocator->release(inReleaseContext, bufferLength);
 		};
 	}
 	
@@ -999,13 +2135,21 @@ GLBufferRef CreateRGBAFloatCPUBuffer(const Size & size, const GLBufferPoolRef &
 	
 	GLBufferRef		returnMe = inPoolRef->fetchMatchingFreeBuffer(desc, size);
 	if (returnMe == nullptr)	{
-		void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+		size_t			bufferLength = desc.backingLengthForSize(size);
+		GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+		void			*bufferMemory = allocator->allocate(bufferLength);
+		if (bufferMemory == nullptr)
+			return nullptr;
 		returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, false);
+		if (returnMe == nullptr)	{
+			allocator->release(bufferMemory, bufferLength);
+			return nullptr;
+		}
 		returnMe->parentBufferPool = inPoolRef;
 		returnMe->backingID = GLBuffer::BackingID_Pixels;
 		returnMe->backingContext = bufferMemory;
-		returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-			free(inReleaseContext);
+		returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+			allocator->release(inReleaseContext, bufferLength);
 		};
 	}
 	
@@ -1038,13 +2182,21 @@ GLBufferRef CreateBGRACPUBuffer(const Size & size, const GLBufferPoolRef & inPoo
 	
 	GLBufferRef		returnMe = inPoolRef->fetchMatchingFreeBuffer(desc, size);
 	if (returnMe == nullptr)	{
-		void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+		size_t			bufferLength = desc.backingLengthForSize(size);
+		GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+		void			*bufferMemory = allocator->allocate(bufferLength);
+		if (bufferMemory == nullptr)
+			return nullptr;
 		returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, false);
+		if (returnMe == nullptr)	{
+			allocator->release(bufferMemory, bufferLength);
+			return nullptr;
+		}
 		returnMe->parentBufferPool = inPoolRef;
 		returnMe->backingID = GLBuffer::BackingID_Pixels;
 		returnMe->backingContext = bufferMemory;
-		returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-			free(inReleaseContext);
+		returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+			allocator->release(inReleaseContext, bufferLength);
 		};
 	}
 	
@@ -1071,13 +2223,21 @@ GLBufferRef CreateBGRAFloatCPUBuffer(const Size & size, const GLBufferPoolRef &
 	
 	GLBufferRef		returnMe = inPoolRef->fetchMatchingFreeBuffer(desc, size);
 	if (returnMe == nullptr)	{
-		void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+		size_t			bufferLength = desc.backingLengthForSize(size);
+		GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+		void			*bufferMemory = allocator->allocate(bufferLength);
+		if (bufferMemory == nullptr)
+			return nullptr;
 		returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, false);
+		if (returnMe == nullptr)	{
+			allocator->release(bufferMemory, bufferLength);
+			return nullptr;
+		}
 		returnMe->parentBufferPool = inPoolRef;
 		returnMe->backingID = GLBuffer::BackingID_Pixels;
 		returnMe->backingContext = bufferMemory;
-		returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-			free(inReleaseContext);
+		returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+			allocator->release(inReleaseContext, bufferLength);
 		};
 	}
 	
@@ -1325,6 +2485,126 @@ GLBufferRef CreateRGBAFloatTex(const Size & size, const bool & inCreateInCurrent
 	
 	return returnMe;
 }
+std::shared_future<GLBufferRef> CreateRGBATexAsync(const Size & size, const GLBufferPoolRef & inPoolRef)	{
+	if (inPoolRef == nullptr)	{
+		promise<GLBufferRef>		tmpPromise;
+		tmpPromise.set_value(nullptr);
+		return tmpPromise.get_future().share();
+	}
+	
+	GLBuffer::Descriptor	desc;
+	
+	desc.type = GLBuffer::Type_Tex;
+	desc.target = GLBuffer::Target_2D;
+#if (defined(VVGL_SDK_MAC) || defined(VVGL_SDK_QT))
+	desc.internalFormat = GLBuffer::IF_RGBA8;
+	desc.pixelType = GLBuffer::PT_UInt_8888_Rev;
+#else
+	desc.internalFormat = GLBuffer::IF_RGBA;
+	desc.pixelType = GLBuffer::PT_UByte;
+#endif
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.cpuBackingType = GLBuffer::Backing_None;
+	desc.gpuBackingType = GLBuffer::Backing_Internal;
+	desc.texRangeFlag = false;
+	desc.texClientStorageFlag = false;
+	desc.msAmount = 0;
+	desc.localSurfaceID = 0;
+	
+	return inPoolRef->createBufferRefAsync(desc, size);
+}
+std::shared_future<GLBufferRef> CreateRGBAFloatTexAsync(const Size & size, const GLBufferPoolRef & inPoolRef)	{
+	if (inPoolRef == nullptr)	{
+		promise<GLBufferRef>		tmpPromise;
+		tmpPromise.set_value(nullptr);
+		return tmpPromise.get_future().share();
+	}
+	
+	GLBuffer::Descriptor	desc;
+	
+	desc.type = GLBuffer::Type_Tex;
+	desc.target = GLBuffer::Target_2D;
+#if !defined(VVGL_SDK_RPI)
+	desc.internalFormat = GLBuffer::IF_RGBA32F;
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.pixelType = GLBuffer::PT_Float;
+#else
+	desc.internalFormat = GLBuffer::IF_RGBA;
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.pixelType = GLBuffer::PT_UByte;
+#endif
+	desc.cpuBackingType = GLBuffer::Backing_None;
+	desc.gpuBackingType = GLBuffer::Backing_Internal;
+	desc.texRangeFlag = false;
+	desc.texClientStorageFlag = false;
+	desc.msAmount = 0;
+	desc.localSurfaceID = 0;
+	
+	return inPoolRef->createBufferRefAsync(desc, size);
+}
+vector<GLBufferRef> CreateRGBATexArray(const Size & size, const size_t & count, const bool & inCreateInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
+	if (inPoolRef == nullptr)
+		return vector<GLBufferRef>();
+	
+	GLBuffer::Descriptor	desc;
+	
+	desc.type = GLBuffer::Type_Tex;
+	desc.target = GLBuffer::Target_2D;
+#if (defined(VVGL_SDK_MAC) || defined(VVGL_SDK_QT))
+	desc.internalFormat = GLBuffer::IF_RGBA8;
+	desc.pixelType = GLBuffer::PT_UInt_8888_Rev;
+#else
+	desc.internalFormat = GLBuffer::IF_RGBA;
+	desc.pixelType = GLBuffer::PT_UByte;
+#endif
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.cpuBackingType = GLBuffer::Backing_None;
+	desc.gpuBackingType = GLBuffer::Backing_Internal;
+	desc.texRangeFlag = false;
+	desc.texClientStorageFlag = false;
+	desc.msAmount = 0;
+	desc.localSurfaceID = 0;
+	
+	vector<GLBufferRef>		returnMe = inPoolRef->createBufferRefs(vector<pair<GLBuffer::Descriptor,Size>>(count, make_pair(desc,size)), inCreateInCurrentContext);
+	for (auto & buffer : returnMe)	{
+		if (buffer != nullptr)
+			buffer->parentBufferPool = inPoolRef;
+	}
+	
+	return returnMe;
+}
+vector<GLBufferRef> CreateRGBAFloatTexArray(const Size & size, const size_t & count, const bool & inCreateInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
+	if (inPoolRef == nullptr)
+		return vector<GLBufferRef>();
+	
+	GLBuffer::Descriptor	desc;
+	
+	desc.type = GLBuffer::Type_Tex;
+	desc.target = GLBuffer::Target_2D;
+#if !defined(VVGL_SDK_RPI)
+	desc.internalFormat = GLBuffer::IF_RGBA32F;
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.pixelType = GLBuffer::PT_Float;
+#else
+	desc.internalFormat = GLBuffer::IF_RGBA;
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.pixelType = GLBuffer::PT_UByte;
+#endif
+	desc.cpuBackingType = GLBuffer::Backing_None;
+	desc.gpuBackingType = GLBuffer::Backing_Internal;
+	desc.texRangeFlag = false;
+	desc.texClientStorageFlag = false;
+	desc.msAmount = 0;
+	desc.localSurfaceID = 0;
+	
+	vector<GLBufferRef>		returnMe = inPoolRef->createBufferRefs(vector<pair<GLBuffer::Descriptor,Size>>(count, make_pair(desc,size)), inCreateInCurrentContext);
+	for (auto & buffer : returnMe)	{
+		if (buffer != nullptr)
+			buffer->parentBufferPool = inPoolRef;
+	}
+	
+	return returnMe;
+}
 #if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
 GLBufferRef CreateYCbCrTex(const Size & size, const bool & createInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
 	//cout << __PRETTY_FUNCTION__ << endl;
@@ -1504,13 +2784,21 @@ GLBufferRef CreateRGBACPUBackedTex(const Size & size, const bool & createInCurre
 	if (returnMe != nullptr)
 		return returnMe;
 	
-	void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+	size_t			bufferLength = desc.backingLengthForSize(size);
+	GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+	void			*bufferMemory = allocator->allocate(bufferLength);
+	if (bufferMemory == nullptr)
+		return nullptr;
 	returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, createInCurrentContext);
+	if (returnMe == nullptr)	{
+		allocator->release(bufferMemory, bufferLength);
+		return nullptr;
+	}
 	returnMe->parentBufferPool = inPoolRef;
 	returnMe->backingID = GLBuffer::BackingID_Pixels;
 	returnMe->backingContext = bufferMemory;
-	returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-		free(inReleaseContext);
+	returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+		allocator->release(inReleaseContext, bufferLength);
 	};
 	
 	return returnMe;
@@ -1536,13 +2824,21 @@ GLBufferRef CreateRGBAFloatCPUBackedTex(const Size & size, const bool & createIn
 	if (returnMe != nullptr)
 		return returnMe;
 	
-	void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+	size_t			bufferLength = desc.backingLengthForSize(size);
+	GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+	void			*bufferMemory = allocator->allocate(bufferLength);
+	if (bufferMemory == nullptr)
+		return nullptr;
 	returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, createInCurrentContext);
+	if (returnMe == nullptr)	{
+		allocator->release(bufferMemory, bufferLength);
+		return nullptr;
+	}
 	returnMe->parentBufferPool = inPoolRef;
 	returnMe->backingID = GLBuffer::BackingID_Pixels;
 	returnMe->backingContext = bufferMemory;
-	returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-		free(inReleaseContext);
+	returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+		allocator->release(inReleaseContext, bufferLength);
 	};
 	
 	return returnMe;
@@ -1574,13 +2870,21 @@ GLBufferRef CreateBGRACPUBackedTex(const Size & size, const bool & createInCurre
 	if (returnMe != nullptr)
 		return returnMe;
 	
-	void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+	size_t			bufferLength = desc.backingLengthForSize(size);
+	GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+	void			*bufferMemory = allocator->allocate(bufferLength);
+	if (bufferMemory == nullptr)
+		return nullptr;
 	returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, createInCurrentContext);
+	if (returnMe == nullptr)	{
+		allocator->release(bufferMemory, bufferLength);
+		return nullptr;
+	}
 	returnMe->parentBufferPool = inPoolRef;
 	returnMe->backingID = GLBuffer::BackingID_Pixels;
 	returnMe->backingContext = bufferMemory;
-	returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-		free(inReleaseContext);
+	returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+		allocator->release(inReleaseContext, bufferLength);
 	};
 	
 	return returnMe;
@@ -1606,13 +2910,21 @@ GLBufferRef CreateBGRAFloatCPUBackedTex(const Size & size, const bool & createIn
 	if (returnMe != nullptr)
 		return returnMe;
 	
-	void			*bufferMemory = malloc(desc.backingLengthForSize(size));
+	size_t			bufferLength = desc.backingLengthForSize(size);
+	GLCPUBackingAllocatorRef		allocator = inPoolRef->cpuBackingAllocator();
+	void			*bufferMemory = allocator->allocate(bufferLength);
+	if (bufferMemory == nullptr)
+		return nullptr;
 	returnMe = inPoolRef->createBufferRef(desc, size, bufferMemory, size, createInCurrentContext);
+	if (returnMe == nullptr)	{
+		allocator->release(bufferMemory, bufferLength);
+		return nullptr;
+	}
 	returnMe->parentBufferPool = inPoolRef;
 	returnMe->backingID = GLBuffer::BackingID_Pixels;
 	returnMe->backingContext = bufferMemory;
-	returnMe->backingReleaseCallback = [](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
-		free(inReleaseContext);
+	returnMe->backingReleaseCallback = [allocator,bufferLength](GLBuffer & /*inBuffer*/, void* inReleaseContext)	{
+		allocator->release(inReleaseContext, bufferLength);
 	};
 	
 	return returnMe;
@@ -1736,8 +3048,8 @@ GLBufferRef CreateCubeTexFromImagePaths(const vector<string> & /*inPaths*/, cons
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+//	PBOs aren't available in ES 2
+#if !defined(VVGL_TARGETENV_GLES)
 
 /*
 "pack" means this PBO will be used to transfer pixel data TO a PBO (glReadPixels(), glGetTexImage())
@@ -1841,6 +3153,62 @@ GLBufferRef CreateRGBAPBO(const GLBuffer::Target & inTarget, const int32_t & inU
 	
 	return returnMe;
 }
+vector<GLBufferRef> CreateRGBAPBOArray(const GLBuffer::Target & inTarget, const int32_t & inUsage, const Size & inSize, const size_t & inCount, const bool & inCreateInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
+	if (inPoolRef == nullptr)
+		return vector<GLBufferRef>();
+	
+	GLBuffer::Descriptor	desc;
+	
+	desc.type = GLBuffer::Type_PBO;
+	desc.target = inTarget;
+#if defined(VVGL_SDK_MAC)
+	desc.internalFormat = GLBuffer::IF_RGBA8;
+	desc.pixelType = GLBuffer::PT_UInt_8888_Rev;
+#else
+	desc.internalFormat = GLBuffer::IF_RGBA;
+	desc.pixelType = GLBuffer::PT_UByte;
+#endif
+	desc.pixelFormat = GLBuffer::PF_RGBA;
+	desc.cpuBackingType = GLBuffer::Backing_None;
+	desc.gpuBackingType = GLBuffer::Backing_Internal;
+	desc.texRangeFlag = false;
+	desc.texClientStorageFlag = false;
+	desc.msAmount = 0;
+	desc.localSurfaceID = 0;
+	
+	vector<GLBufferRef>		returnMe = inPoolRef->createBufferRefs(vector<pair<GLBuffer::Descriptor,Size>>(inCount, make_pair(desc,inSize)), inCreateInCurrentContext);
+	
+	//	the pool doesn't make its context current if it recycled all of the PBOs
+	if (!inCreateInCurrentContext)	{
+		GLContextRef		tmpCtx = inPoolRef->context();
+		if (tmpCtx == nullptr)
+			return vector<GLBufferRef>();
+		tmpCtx->makeCurrentIfNotCurrent();
+	}
+	
+	//	reserve-initialize every PBO (new PBOs don't have a data store yet, and recycled PBOs are orphaned)
+	size_t			pboSizeInBytes = desc.backingLengthForSize(inSize);
+	for (auto & buffer : returnMe)	{
+		if (buffer == nullptr)
+			continue;
+		buffer->parentBufferPool = inPoolRef;
+		buffer->backingSize = inSize;
+		glBindBuffer(buffer->desc.target, buffer->name);
+		GLERRLOG
+		if (buffer->pboMapped)	{
+			glUnmapBuffer(inTarget);
+			GLERRLOG
+			buffer->pboMapped = false;
+			buffer->cpuBackingPtr = nullptr;
+		}
+		glBufferData(inTarget, pboSizeInBytes, nullptr, inUsage);
+		GLERRLOG
+	}
+	glBindBuffer(inTarget, 0);
+	GLERRLOG
+	
+	return returnMe;
+}
 GLBufferRef CreateBGRAPBO(const int32_t & inTarget, const int32_t & inUsage, const Size & inSize, const void * inData, const bool & inCreateInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
 	if (inPoolRef == nullptr)
 		return nullptr;
@@ -2101,6 +3469,7 @@ GLBufferRef CreateBGRAFloatPBO(const int32_t & inTarget, const int32_t & inUsage
 	
 	return returnMe;
 }
+#if !defined(VVGL_TARGETENV_GLES3)
 GLBufferRef CreateYCbCrPBO(const int32_t & inTarget, const int32_t & inUsage, const Size & inSize, const void * inData, const bool & inCreateInCurrentContext, const GLBufferPoolRef & inPoolRef)	{
 	if (inPoolRef == nullptr)
 		return nullptr;
@@ -2186,8 +3555,9 @@ GLBufferRef CreateYCbCrPBO(const int32_t & inTarget, const int32_t & inUsage, co
 	
 	return returnMe;
 }
+#endif	//	!defined(VVGL_TARGETENV_GLES3)
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -1,10 +1,13 @@
 #include "GLCPUToTexCopier.hpp"
+#include "VVGL_RowCopy.hpp"
 
+#include <cmath>
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+
+//	none of this stuff should be available if we're running ES 2 (there are no PBOs)
+#if !defined(VVGL_TARGETENV_GLES)
 
 
 
@@ -15,6 +18,16 @@
 //	CPU data to it manually.  path 1 is slightly faster on the mac i'm writing this on.
 #define PATHTYPE 1
 
+//	persistently-mapped buffers (ARB_buffer_storage/GL 4.4) aren't available on the mac- on the other 
+//	platforms we're using GLEW, so we can check for the extension at runtime.
+#if defined(VVGL_SDK_GLFW) || defined(VVGL_SDK_QT) || defined(VVGL_SDK_WIN)
+	#define PERSISTENTRING 1
+#else
+	#define PERSISTENTRING 0
+#endif
+//	slots in the ring are aligned to this many bytes
+#define RINGSLOTALIGNMENT 256
+
 
 
 
@@ -27,6 +40,64 @@ using namespace std;
 
 
 
+/*	========================================	*/
+#pragma mark --------------------- upload ring
+
+
+//	a single unpack buffer, persistently mapped and split into slots.  slots are marked busy while a 
+//	CPU buffer from nextPersistentRingBuffer() points into them- those buffers retain the ring, so the 
+//	PBO isn't deleted until the last of them has been freed.  each slot's fence guards the last upload 
+//	from it, so a slot is only written to again once it isn't busy and its upload has completed.
+struct GLCPUToTexCopier::UploadRing	{
+	GLBufferRef			pbo = nullptr;	//	created by the pool, so the pool deletes it when the ring is freed
+	uint8_t				*ptr = nullptr;
+	size_t				slotBytes = 0;
+	int					slotCount = 0;
+	vector<GLsync>		fences;	//	one per slot.  only accessed by the copier that made the ring (with its _queueLock locked).
+	
+	mutex				lock;	//	used to serialize access to 'busy' and 'nextSlot'
+	vector<bool>		busy;
+	int					nextSlot = 0;
+	
+	//	returns the index of a slot that isn't busy (and marks it busy), or -1 if every slot is busy
+	int claimSlot()	{
+		lock_guard<mutex>		tmpLock(lock);
+		for (int i=0; i<slotCount; ++i)	{
+			int			slot = (nextSlot + i) % slotCount;
+			if (!busy[static_cast<size_t>(slot)])	{
+				busy[static_cast<size_t>(slot)] = true;
+				nextSlot = (slot + 1) % slotCount;
+				return slot;
+			}
+		}
+		return -1;
+	}
+	void releaseSlot(const int & inSlot)	{
+		lock_guard<mutex>		tmpLock(lock);
+		if (inSlot>=0 && inSlot<slotCount)
+			busy[static_cast<size_t>(inSlot)] = false;
+	}
+	uint8_t * slotPtr(const int & inSlot) const { return ptr + (static_cast<size_t>(inSlot) * slotBytes); }
+	//	returns the index of the slot that starts at the passed address, or -1 if it isn't in the ring
+	int slotForPtr(const void * inPtr) const	{
+		const uint8_t		*tmpPtr = static_cast<const uint8_t*>(inPtr);
+		if (tmpPtr==nullptr || tmpPtr<ptr || tmpPtr>=(ptr + (slotBytes * static_cast<size_t>(slotCount))))
+			return -1;
+		size_t				offset = static_cast<size_t>(tmpPtr - ptr);
+		if (offset % slotBytes != 0)
+			return -1;
+		return static_cast<int>(offset / slotBytes);
+	}
+};
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- constructor/destructor
+
+
+
 GLCPUToTexCopier::GLCPUToTexCopier()	{
 	GLBufferPoolRef		bp = (_privatePool==nullptr) ? GetGlobalBufferPool() : _privatePool;
 	if (bp != nullptr)
@@ -37,31 +108,114 @@ GLCPUToTexCopier::~GLCPUToTexCopier()	{
 }
 void GLCPUToTexCopier::clearStream()	{
 	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
 	while (_cpuQueue.size() > 0)
-		_cpuQueue.pop();
-	while (_pboQueue.size() > 0)
-		_pboQueue.pop();
-	while (_texQueue.size() > 0)
-		_texQueue.pop();
+		_dropUpload();
+	_adaptiveDepth.reset();
+	_destroyRing();
 }
 void GLCPUToTexCopier::setQueueSize(const int & inNewQueueSize)	{
 	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
 	
 	_queueSize = inNewQueueSize;
 	if (_queueSize < 0)
 		_queueSize = 0;
 	
+	//	a manually-set size is the adaptive mode's new starting point
+	_adaptiveDepth.setDepth(_queueSize);
+	
 	while (static_cast<int>(_cpuQueue.size()) > _queueSize)
-		_cpuQueue.pop();
-	while (static_cast<int>(_pboQueue.size()) > _queueSize)
-		_pboQueue.pop();
-	while (static_cast<int>(_texQueue.size()) > _queueSize)
-		_texQueue.pop();
+		_dropUpload();
+	
+	//	the number of slots in the ring depends on the queue size- _ensureRing() replaces it on the next upload
+}
+void GLCPUToTexCopier::setAdaptiveQueueSize(const bool & n)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveQueueSize = n;
+	if (_adaptiveQueueSize)	{
+		_adaptiveDepth.setDepth(_queueSize);
+		_applyAdaptiveDepth();
+	}
+	//	the number of slots in the ring depends on whether or not the queue size is adaptive- _ensureRing() replaces it on the next upload
+}
+void GLCPUToTexCopier::setAdaptiveQueueLimits(const int & inMin, const int & inMax)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveDepth.setLimits(inMin, inMax);
+	_applyAdaptiveDepth();
+}
+void GLCPUToTexCopier::setTargetLatency(const double & inSeconds)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveDepth.setTargetLatency(inSeconds);
+	_applyAdaptiveDepth();
+}
+void GLCPUToTexCopier::setPersistentMapping(const bool & n)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_persistentMapping = n;
+	//	buffers from nextPersistentRingBuffer() retain the ring, so they stay valid- the copier just stops using it
+	if (!_persistentMapping)	{
+		_makeQueueCtxCurrentForDrops();
+		_destroyRing();
+	}
+}
+bool GLCPUToTexCopier::persistentMappingAvailable()	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	return _ringAvailable();
+}
+GLBufferRef GLCPUToTexCopier::nextPersistentRingBuffer(const Size & inSize, const GLBuffer::PixelFormat & inPixelFormat, const bool & inFloat, const bool & createInCurrentContext)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	if (!_ringAvailable())
+		return nullptr;
+	
+	//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
+	if (!createInCurrentContext)
+		_queueCtx->makeCurrentIfNotCurrent();
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	//	make the buffer first (with a null backing) so we know how many bytes it needs
+	GLBufferRef			returnMe = nullptr;
+	switch (inPixelFormat)	{
+	case GLBuffer::PF_RGBA:
+		returnMe = (inFloat)
+			? CreateRGBAFloatCPUBufferUsing(inSize, nullptr, inSize, nullptr, nullptr, bp)
+			: CreateRGBACPUBufferUsing(inSize, nullptr, inSize, nullptr, nullptr, bp);
+		break;
+	case GLBuffer::PF_BGRA:
+		returnMe = (inFloat)
+			? CreateBGRAFloatCPUBufferUsing(inSize, nullptr, inSize, nullptr, nullptr, bp)
+			: CreateBGRACPUBufferUsing(inSize, nullptr, inSize, nullptr, nullptr, bp);
+		break;
+#if !defined(VVGL_TARGETENV_GLES3)
+	case GLBuffer::PF_YCbCr_422:
+		returnMe = CreateYCbCrCPUBufferUsing(inSize, nullptr, inSize, nullptr, nullptr, bp);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (returnMe == nullptr)
+		return nullptr;
+	
+	if (!_ensureRing(returnMe->calculateBackingLength(), createInCurrentContext))
+		return nullptr;
+	int			slot = _claimRingSlot();
+	if (slot < 0)
+		return nullptr;
+	
+	//	the buffer retains the ring, and releases its slot when it's freed
+	shared_ptr<UploadRing>		ring = _uploadRing;
+	returnMe->cpuBackingPtr = ring->slotPtr(slot);
+	returnMe->backingReleaseCallback = [ring,slot](GLBuffer & /*inBuffer*/, void * /*inContext*/)	{
+		ring->releaseSlot(slot);
+	};
+	return returnMe;
 }
 
 
 void GLCPUToTexCopier::_beginProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer)	{
-
 #if PATHTYPE==0
 	//	intentionally blank
 	if (inCPUBuffer==nullptr || inPBOBuffer==nullptr || inTexBuffer==nullptr)
@@ -73,31 +227,20 @@ void GLCPUToTexCopier::_beginProcessing(const GLBufferRef & inCPUBuffer, const G
 	glBindBuffer(inPBOBuffer->desc.target, inPBOBuffer->name);
 	GLERRLOG
 	//	map the PBO- this should return immediately, provided that we discard-initialized the PBO just before this
+#if defined(VVGL_TARGETENV_GLES3)
+	//	ES3 doesn't have glMapBuffer()- the buffer was just orphaned, so we can invalidate it while mapping it
+	inPBOBuffer->cpuBackingPtr = glMapBufferRange(inPBOBuffer->desc.target, 0, static_cast<GLsizeiptr>(inPBOBuffer->calculateBackingLength()), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	GLERRLOG
+#else
 	inPBOBuffer->cpuBackingPtr = glMapBuffer(inPBOBuffer->desc.target, GL_WRITE_ONLY);
 	GLERRLOG
+#endif
 	inPBOBuffer->pboMapped = (inPBOBuffer->cpuBackingPtr != NULL) ? true : false;
 	if (!inPBOBuffer->pboMapped)
 		cout << "\tERR: couldnt map PBO in " << __PRETTY_FUNCTION__ << endl;
 	else	{
 		//	copy the data from the cpu buffer to the PBO
-		size_t		cpuBPR = inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inCPUBuffer->size.width));
-		size_t		pboBPR = inPBOBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inPBOBuffer->size.width));
-		uint8_t		*rPtr = (uint8_t*)inCPUBuffer->cpuBackingPtr;
-		uint8_t		*wPtr = (uint8_t*)inPBOBuffer->cpuBackingPtr;
-
-		//	if the cpu buffer's bytes per row differs from the PBO's bytes per row, we have to copy one row at a time
-		if (cpuBPR != pboBPR)	{
-			size_t		copyBytesPerRow = (cpuBPR<pboBPR) ? cpuBPR : pboBPR;
-			for (int i=0; i<inPBOBuffer->size.height; ++i)	{
-				memcpy(wPtr, rPtr, copyBytesPerRow);
-				wPtr += cpuBPR;
-				rPtr += pboBPR;
-			}
-		}
-		//	else the CPU buffer and the PBO have the same exact number of bytes per row- we can copy their contents in a single call
-		else	{
-			memcpy(wPtr, rPtr, pboBPR * static_cast<size_t>(round(inPBOBuffer->size.height)));
-		}
+		CopyBufferRows(inCPUBuffer, inPBOBuffer);
 		//	unmap the PBO
 		glUnmapBuffer(inPBOBuffer->desc.target);
 		GLERRLOG
@@ -111,9 +254,10 @@ void GLCPUToTexCopier::_beginProcessing(const GLBufferRef & inCPUBuffer, const G
 	glFlush();
 	GLERRLOG
 #endif	//	PATHTYPE==1
-
 }
-void GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer)	{
+GLsync GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const bool & inFence)	{
+	GLsync			returnMe = nullptr;
+	
 	/*
 	if (inCPUBuffer==nullptr || inPBOBuffer==nullptr || inTexBuffer==nullptr)
 		return;
@@ -128,11 +272,40 @@ void GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 	
 	
 	if (inCPUBuffer==nullptr || inPBOBuffer==nullptr || inTexBuffer==nullptr)
-		return;
+		return returnMe;
+	
+	_uploadFromPBO(inCPUBuffer, inPBOBuffer->name, 0, inTexBuffer);
+	
+	//	insert a fence after the upload- it's signaled when the texture's contents have been uploaded from the PBO
+	if (inFence && _queueCtx!=nullptr && (_queueCtx->version==GLVersion_33 || _queueCtx->version==GLVersion_4 || _queueCtx->version==GLVersion_ES3))	{
+		returnMe = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		GLERRLOG
+	}
+	
+	//	flush- start the DMA transfer.  the CPU doesn't wait for this to complete, and returns immediately.
+	glFlush();
+	GLERRLOG
+	
+	//	timestamp the buffer...
+	GLBufferPoolRef		bp = (_privatePool==nullptr) ? GetGlobalBufferPool() : _privatePool;
+	if (bp == nullptr)
+		return returnMe;
+	bp->timestampThisBuffer(inTexBuffer);
+	
+	//	make sure the buffers inherit the source's flippedness and timestamp
+	inPBOBuffer->flipped = inCPUBuffer->flipped;
+	inPBOBuffer->contentTimestamp = inCPUBuffer->contentTimestamp;
+	inTexBuffer->flipped = inCPUBuffer->flipped;
+	inTexBuffer->contentTimestamp = inCPUBuffer->contentTimestamp;
 	
+	return returnMe;
+}
+
+
+void GLCPUToTexCopier::_uploadFromPBO(const GLBufferRef & inCPUBuffer, const uint32_t & inPBOName, const size_t & inPBOOffset, const GLBufferRef & inTexBuffer)	{
 	GLVersion		myVers = _queueCtx->version;
 	//	bind the PBO and texture
-	glBindBuffer(inPBOBuffer->desc.target, inPBOBuffer->name);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, inPBOName);
 	GLERRLOG
 	
 	if (myVers==GLVersion_2)	{
@@ -145,12 +318,15 @@ void GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 	//	set up some pixel transfer modes
 	glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(inCPUBuffer->size.width));
 	GLERRLOG
+	//	ES3 has neither client storage nor byte swapping
+#if !defined(VVGL_TARGETENV_GLES3)
 #if !defined(Q_OS_WIN)
 	glPixelStorei(GL_UNPACK_CLIENT_STORAGE_APPLE, GL_TRUE);
 	GLERRLOG
 #endif
 	glPixelStorei(GL_UNPACK_SWAP_BYTES, (_swapBytes) ? GL_TRUE : GL_FALSE);
 	GLERRLOG
+#endif
 	
 	//	start copying the buffer data from the PBO to the texture
 	glTexSubImage2D(inTexBuffer->desc.target,
@@ -161,15 +337,17 @@ void GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 		static_cast<GLsizei>(inCPUBuffer->srcRect.size.height),
 		inTexBuffer->desc.pixelFormat, 
 		inTexBuffer->desc.pixelType,
-		0);
+		reinterpret_cast<const GLvoid*>(inPBOOffset));
 	GLERRLOG
 	
 	//	tear down pixel transfer modes
+#if !defined(VVGL_TARGETENV_GLES3)
 	glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
 	GLERRLOG
 #if !defined(Q_OS_WIN)
 	glPixelStorei(GL_UNPACK_CLIENT_STORAGE_APPLE, GL_FALSE);
 	GLERRLOG
+#endif
 #endif
 	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 	GLERRLOG
@@ -182,24 +360,209 @@ void GLCPUToTexCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 		GLERRLOG
 	}
 	
-	glBindBuffer(inPBOBuffer->desc.target, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 	GLERRLOG
-	//	flush- start the DMA transfer.  the CPU doesn't wait for this to complete, and returns immediately.
+}
+
+
+bool GLCPUToTexCopier::_ringAvailable()	{
+#if PERSISTENTRING
+	if (!_persistentMapping || _queueCtx==nullptr)
+		return false;
+	if (_queueCtx->version!=GLVersion_33 && _queueCtx->version!=GLVersion_4)
+		return false;
+	return (GLEW_ARB_buffer_storage) ? true : false;
+#else
+	return false;
+#endif
+}
+bool GLCPUToTexCopier::_ensureRing(const size_t & inSlotBytes, const bool & createInCurrentContext)	{
+#if PERSISTENTRING
+	size_t		slotBytes = ((inSlotBytes + RINGSLOTALIGNMENT - 1) / RINGSLOTALIGNMENT) * RINGSLOTALIGNMENT;
+	int			slotCount = _ringSlotCount();
+	//	if the ring already exists and is large enough, we're done
+	if (_uploadRing!=nullptr && _uploadRing->slotBytes>=slotBytes && _uploadRing->slotCount==slotCount)
+		return true;
+	
+	//	release the old ring- any CPU buffers that point into it keep it alive
+	_destroyRing();
+	
+	//	the ring's PBO is made by the pool (so the pool accounts for it and deletes it), and then its storage is made immutable and persistently mapped.  slots are a multiple of RINGSLOTALIGNMENT bytes, so they're a whole number of RGBA pixels.
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	Size				ringSize(static_cast<double>(slotBytes / 4), static_cast<double>(slotCount));
+	GLBufferRef			ringPBO = CreateRGBAPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, ringSize, nullptr, createInCurrentContext, bp);
+	if (ringPBO == nullptr)
+		return false;
+	//	immutable storage can't be recycled by the pool
+	ringPBO->preferDeletion = true;
+	
+	GLbitfield		flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr		totalBytes = static_cast<GLsizeiptr>(slotBytes * static_cast<size_t>(slotCount));
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ringPBO->name);
+	GLERRLOG
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, flags);
+	GLERRLOG
+	void			*ringPtr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes, flags);
+	GLERRLOG
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLERRLOG
+	//	deleting the buffer unmaps it, so the pool doesn't need to know that it's mapped
+	if (ringPtr == nullptr)	{
+		cout << "\tERR: couldnt map persistent PBO in " << __PRETTY_FUNCTION__ << endl;
+		return false;
+	}
+	
+	_uploadRing = make_shared<UploadRing>();
+	_uploadRing->pbo = ringPBO;
+	_uploadRing->ptr = static_cast<uint8_t*>(ringPtr);
+	_uploadRing->slotBytes = slotBytes;
+	_uploadRing->slotCount = slotCount;
+	_uploadRing->fences.resize(static_cast<size_t>(slotCount), nullptr);
+	_uploadRing->busy.resize(static_cast<size_t>(slotCount), false);
+	return true;
+#else
+	(void)inSlotBytes;
+	(void)createInCurrentContext;
+	return false;
+#endif
+}
+int GLCPUToTexCopier::_claimRingSlot()	{
+	if (_uploadRing == nullptr)
+		return -1;
+	int			returnMe = _uploadRing->claimSlot();
+	if (returnMe < 0)
+		return returnMe;
+	
+	//	if the slot was uploaded from, wait until the GPU is done with it.  with a ring of queueSize()+2 slots, this should have completed long ago.
+	GLsync		&fence = _uploadRing->fences[static_cast<size_t>(returnMe)];
+	if (fence != nullptr)	{
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		GLERRLOG
+		glDeleteSync(fence);
+		GLERRLOG
+		fence = nullptr;
+	}
+	return returnMe;
+}
+int GLCPUToTexCopier::_ringSlotForPtr(const void * inPtr)	{
+	if (_uploadRing == nullptr)
+		return -1;
+	return _uploadRing->slotForPtr(inPtr);
+}
+GLsync GLCPUToTexCopier::_beginRingProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inTexBuffer, const int & inSlot, const bool & inCopyToSlot)	{
+	GLsync			returnMe = nullptr;
+	if (inCPUBuffer==nullptr || inTexBuffer==nullptr || _uploadRing==nullptr)
+		return returnMe;
+	
+	//	if the CPU buffer came from nextPersistentRingBuffer() its data is already in the slot- otherwise copy it in
+	if (inCopyToSlot)	{
+		size_t		length = inCPUBuffer->calculateBackingLength();
+		CopyRows(inCPUBuffer->cpuBackingPtr, length, _uploadRing->slotPtr(inSlot), length, length, 1);
+	}
+	
+	//	the upload is sourced directly from the slot- the mapping is coherent, so there's nothing to flush or unmap first
+	_uploadFromPBO(inCPUBuffer, _uploadRing->pbo->name, static_cast<size_t>(inSlot) * _uploadRing->slotBytes, inTexBuffer);
+	
+	//	fence the slot so we know when it can be written to again
+	GLsync		&fence = _uploadRing->fences[static_cast<size_t>(inSlot)];
+	if (fence != nullptr)	{
+		glDeleteSync(fence);
+		GLERRLOG
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GLERRLOG
+	//	...and fence the upload separately for the queue, which deletes its fence when the upload is popped
+	returnMe = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GLERRLOG
+	
+	//	a slot we copied into is only guarded by its fence from now on
+	if (inCopyToSlot)
+		_uploadRing->releaseSlot(inSlot);
+	
 	glFlush();
 	GLERRLOG
 	
 	//	timestamp the buffer...
 	GLBufferPoolRef		bp = (_privatePool==nullptr) ? GetGlobalBufferPool() : _privatePool;
-	if (bp == nullptr)
-		return;
-	bp->timestampThisBuffer(inTexBuffer);
+	if (bp != nullptr)
+		bp->timestampThisBuffer(inTexBuffer);
 	
-	//	make sure the buffers inherit the source's flippedness and timestamp
-	inPBOBuffer->flipped = inCPUBuffer->flipped;
-	inPBOBuffer->contentTimestamp = inCPUBuffer->contentTimestamp;
+	//	make sure the texture inherits the source's flippedness and timestamp
 	inTexBuffer->flipped = inCPUBuffer->flipped;
 	inTexBuffer->contentTimestamp = inCPUBuffer->contentTimestamp;
+	
+	return returnMe;
+}
+int GLCPUToTexCopier::_ringSlotCount()	{
+	//	the ring is sized for the largest queue the adaptive mode may choose, so it doesn't have to be recreated when the queue size changes
+	int			maxQueueSize = (_adaptiveQueueSize) ? max(_queueSize, _adaptiveDepth.maxDepth()) : _queueSize;
+	return maxQueueSize + 2;
+}
+void GLCPUToTexCopier::_destroyRing()	{
+	if (_uploadRing == nullptr)
+		return;
+	
+	//	the copier won't write to the ring again, so its fences aren't needed.  sync objects are shared, so they're deleted in whatever context is current.
+	for (GLsync & fence : _uploadRing->fences)	{
+		if (fence != nullptr)	{
+			glDeleteSync(fence);
+			GLERRLOG
+			fence = nullptr;
+		}
+	}
+	//	the PBO is deleted by the pool once the last CPU buffer pointing into the ring has been freed
+	_uploadRing = nullptr;
+}
+
+
+void GLCPUToTexCopier::_dropUpload()	{
+	if (_cpuQueue.size() < 1)
+		return;
+	
+	_cpuQueue.pop();
+	_pboQueue.pop();
+	_texQueue.pop();
+	_adaptiveDepth.noteDrop();
+	
+	//	sync objects are shared, so the fence is deleted in whatever context is current (the setters make the queue context current first)
+	GLsync			tmpFence = _fenceQueue.front();
+	_fenceQueue.pop_front();
+	if (tmpFence != nullptr)	{
+		glDeleteSync(tmpFence);
+		GLERRLOG
+	}
+}
+void GLCPUToTexCopier::_makeQueueCtxCurrentForDrops()	{
+	//	only the setters need this- the stream paths already have a context that shares the queue context current
+	if (_queueCtx != nullptr && (_fenceQueue.size() > 0 || _uploadRing != nullptr))
+		_queueCtx->makeCurrentIfNotCurrent();
 }
+void GLCPUToTexCopier::_measureTransfers()	{
+	//	transfers complete in order, so we can stop at the first one that hasn't completed yet
+	int			index = 0;
+	for (const GLsync & fence : _fenceQueue)	{
+		if (!_adaptiveDepth.isComplete(index))	{
+			if (fence == nullptr)
+				break;
+			GLenum			waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			GLERRLOG
+			if (waitResult!=GL_ALREADY_SIGNALED && waitResult!=GL_CONDITION_SATISFIED)
+				break;
+			_adaptiveDepth.noteCompletion(index);
+		}
+		++index;
+	}
+}
+void GLCPUToTexCopier::_applyAdaptiveDepth()	{
+	if (!_adaptiveQueueSize || _queueSize == _adaptiveDepth.depth())
+		return;
+	_queueSize = _adaptiveDepth.depth();
+	//	the queues only shrink by dropping their oldest entries
+	while (static_cast<int>(_cpuQueue.size()) > _queueSize)
+		_dropUpload();
+}
+
+
 
 
 GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
@@ -225,6 +588,8 @@ GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, co
 				texBuffer = CreateRGBATex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			}
 			break;
+		//	BGRA textures aren't available on iOS
+#if !defined(VVGL_SDK_IOS)
 		case GLBuffer::PF_BGRA:
 			if (inCPUBuffer->desc.pixelType == GLBuffer::PT_Float)	{
 				texBuffer = CreateBGRAFloatTex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
@@ -233,9 +598,12 @@ GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, co
 				texBuffer = CreateBGRATex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			}
 			break;
+#endif
+#if !defined(VVGL_TARGETENV_GLES3)
 		case GLBuffer::PF_YCbCr_422:
 			texBuffer = CreateRGBATex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			break;
+#endif
 		default:
 			break;
 		}
@@ -318,6 +686,7 @@ GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, co
 				bp);
 		}
 		break;
+#if !defined(VVGL_TARGETENV_GLES3)
 	case GLBuffer::PF_YCbCr_422:
 		pboBuffer = CreateYCbCrPBO(
 			GLBuffer::Target_PBOUnpack,
@@ -331,6 +700,7 @@ GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, co
 			createInCurrentContext,
 			bp);
 		break;
+#endif
 	default:
 		break;
 	}
@@ -343,6 +713,184 @@ GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, co
 	
 	return inTexBuffer;
 }
+//	clips the passed rects to whole pixels within the passed bounds (aligning them horizontally to the passed number of pixels), 
+//	and merges rects that overlap or touch as long as the merged rect isn't much larger than the rects it replaces
+static vector<Rect> CoalesceDirtyRects(const vector<Rect> & inRects, const Size & inBounds, const double & inXAlign)	{
+	vector<Rect>		returnMe;
+	for (const Rect & rect : inRects)	{
+		double			minX = fmax(0., floor(floor(rect.minX()) / inXAlign) * inXAlign);
+		double			minY = fmax(0., floor(rect.minY()));
+		double			maxX = fmin(inBounds.width, ceil(ceil(rect.maxX()) / inXAlign) * inXAlign);
+		double			maxY = fmin(inBounds.height, ceil(rect.maxY()));
+		if (maxX>minX && maxY>minY)
+			returnMe.push_back(Rect(minX, minY, maxX-minX, maxY-minY));
+	}
+	
+	auto		area = [](const Rect & r)	{ return r.size.width * r.size.height; };
+	bool		merged = true;
+	while (merged)	{
+		merged = false;
+		for (size_t i=0; i<returnMe.size() && !merged; ++i)	{
+			for (size_t j=i+1; j<returnMe.size() && !merged; ++j)	{
+				const Rect		&a = returnMe[i];
+				const Rect		&b = returnMe[j];
+				//	the rects have to overlap or share an edge
+				if (a.minX()>b.maxX() || b.minX()>a.maxX() || a.minY()>b.maxY() || b.minY()>a.maxY())
+					continue;
+				double			minX = fmin(a.minX(), b.minX());
+				double			minY = fmin(a.minY(), b.minY());
+				Rect			u(minX, minY, fmax(a.maxX(), b.maxX())-minX, fmax(a.maxY(), b.maxY())-minY);
+				//	uploading a few extra pixels is cheaper than another glTexSubImage2D()
+				if (area(u) > (area(a) + area(b)) * 1.25)
+					continue;
+				returnMe[i] = u;
+				returnMe.erase(returnMe.begin() + static_cast<long>(j));
+				merged = true;
+			}
+		}
+	}
+	return returnMe;
+}
+GLBufferRef GLCPUToTexCopier::uploadCPUToTex(const GLBufferRef & inCPUBuffer, const GLBufferRef & inTexBuffer, const vector<Rect> & inDirtyRects, const bool & createInCurrentContext)	{
+	if (inCPUBuffer==nullptr || inTexBuffer==nullptr || inCPUBuffer->cpuBackingPtr==nullptr)
+		return nullptr;
+	
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	
+	//	work out which regions we're uploading (YCbCr pixels come in pairs)
+	Size				bounds(fmin(inCPUBuffer->size.width, inTexBuffer->size.width), fmin(inCPUBuffer->size.height, inTexBuffer->size.height));
+#if !defined(VVGL_TARGETENV_GLES3)
+	double				xAlign = (inCPUBuffer->desc.pixelFormat==GLBuffer::PF_YCbCr_422) ? 2. : 1.;
+#else
+	double				xAlign = 1.;
+#endif
+	vector<Rect>		rects = CoalesceDirtyRects(inDirtyRects, bounds, xAlign);
+	if (rects.size() < 1)
+		return inTexBuffer;
+	
+	//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
+	if (!createInCurrentContext)
+		_queueCtx->makeCurrentIfNotCurrent();
+	
+	//	make a PBO with the same layout as the CPU buffer- we only write (and upload) the dirty regions
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	bool				isFloat = (inCPUBuffer->desc.pixelType == GLBuffer::PT_Float);
+	GLBufferRef			pboBuffer = nullptr;
+	switch (inCPUBuffer->desc.pixelFormat)	{
+	case GLBuffer::PF_RGBA:
+		pboBuffer = (isFloat)
+			? CreateRGBAFloatPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, inCPUBuffer->size, nullptr, createInCurrentContext, bp)
+			: CreateRGBAPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, inCPUBuffer->size, nullptr, createInCurrentContext, bp);
+		break;
+	case GLBuffer::PF_BGRA:
+		pboBuffer = (isFloat)
+			? CreateBGRAFloatPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, inCPUBuffer->size, nullptr, createInCurrentContext, bp)
+			: CreateBGRAPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, inCPUBuffer->size, nullptr, createInCurrentContext, bp);
+		break;
+#if !defined(VVGL_TARGETENV_GLES3)
+	case GLBuffer::PF_YCbCr_422:
+		pboBuffer = CreateYCbCrPBO(GLBuffer::Target_PBOUnpack, GL_STREAM_DRAW, inCPUBuffer->size, nullptr, createInCurrentContext, bp);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (pboBuffer == nullptr)
+		return nullptr;
+	
+	//	map the PBO and copy the dirty regions into it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboBuffer->name);
+	GLERRLOG
+#if defined(VVGL_TARGETENV_GLES3)
+	uint8_t				*pboPtr = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(pboBuffer->calculateBackingLength()), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	GLERRLOG
+#else
+	uint8_t				*pboPtr = static_cast<uint8_t*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+	GLERRLOG
+#endif
+	if (pboPtr == nullptr)	{
+		cout << "\tERR: couldnt map PBO in " << __PRETTY_FUNCTION__ << endl;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GLERRLOG
+		return nullptr;
+	}
+	const uint8_t		*cpuPtr = static_cast<const uint8_t*>(inCPUBuffer->cpuBackingPtr);
+	size_t				bytesPerRow = inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inCPUBuffer->size.width));
+	for (const Rect & rect : rects)	{
+		size_t				offset = static_cast<size_t>(rect.minY()) * bytesPerRow + inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(rect.minX()));
+		size_t				rowBytes = inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(rect.size.width));
+		CopyRows(cpuPtr + offset, bytesPerRow, pboPtr + offset, bytesPerRow, rowBytes, static_cast<size_t>(rect.size.height));
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	GLERRLOG
+	
+	//	bind the texture
+	GLVersion			myVers = _queueCtx->version;
+	if (myVers==GLVersion_2)	{
+		glEnable(inTexBuffer->desc.target);
+		GLERRLOG
+	}
+	glBindTexture(inTexBuffer->desc.target, inTexBuffer->name);
+	GLERRLOG
+	
+	//	upload each region from its position in the PBO
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(inCPUBuffer->size.width));
+	GLERRLOG
+#if !defined(VVGL_TARGETENV_GLES3)
+	glPixelStorei(GL_UNPACK_SWAP_BYTES, (_swapBytes) ? GL_TRUE : GL_FALSE);
+	GLERRLOG
+#endif
+	for (const Rect & rect : rects)	{
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, static_cast<GLint>(rect.minX()));
+		GLERRLOG
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, static_cast<GLint>(rect.minY()));
+		GLERRLOG
+		glTexSubImage2D(inTexBuffer->desc.target,
+			0,
+			static_cast<GLint>(rect.minX()),
+			static_cast<GLint>(rect.minY()),
+			static_cast<GLsizei>(rect.size.width),
+			static_cast<GLsizei>(rect.size.height),
+			inTexBuffer->desc.pixelFormat,
+			inTexBuffer->desc.pixelType,
+			nullptr);
+		GLERRLOG
+	}
+	
+	//	tear down pixel transfer modes
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	GLERRLOG
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	GLERRLOG
+#if !defined(VVGL_TARGETENV_GLES3)
+	glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+	GLERRLOG
+#endif
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	GLERRLOG
+	
+	//	unbind the PBO and texture
+	glBindTexture(inTexBuffer->desc.target, 0);
+	GLERRLOG
+	if (myVers==GLVersion_2)	{
+		glDisable(inTexBuffer->desc.target);
+		GLERRLOG
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLERRLOG
+	
+	//	flush- start the DMA transfer
+	glFlush();
+	GLERRLOG
+	
+	//	timestamp the texture, and make sure it inherits the source's flippedness and timestamp
+	if (bp != nullptr)
+		bp->timestampThisBuffer(inTexBuffer);
+	inTexBuffer->flipped = inCPUBuffer->flipped;
+	inTexBuffer->contentTimestamp = inCPUBuffer->contentTimestamp;
+	
+	return inTexBuffer;
+}
 GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
 	//cout << __FUNCTION__ << endl;
 	
@@ -381,6 +929,8 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 				inTexBuffer = CreateRGBATex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			}
 			break;
+		//	BGRA textures aren't available on iOS
+#if !defined(VVGL_SDK_IOS)
 		case GLBuffer::PF_BGRA:
 			if (inCPUBuffer->desc.pixelType == GLBuffer::PT_Float)	{
 				inTexBuffer = CreateBGRAFloatTex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
@@ -389,9 +939,12 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 				inTexBuffer = CreateBGRATex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			}
 			break;
+#endif
+#if !defined(VVGL_TARGETENV_GLES3)
 		case GLBuffer::PF_YCbCr_422:
 			inTexBuffer = CreateYCbCrTex(inCPUBuffer->srcRect.size, createInCurrentContext, bp);
 			break;
+#endif
 		default:
 			break;
 		}
@@ -436,9 +989,21 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 	if (tmpQueueSize>=_queueSize && safeToPush)
 		safeToPop = true;
 	
+	//	if we're safe to push and the persistently-mapped ring is available, we don't need a PBO- the upload is performed from the ring when we push.  if every slot is busy, we fall back to a PBO.
+	int				ringSlot = -1;
+	bool			copyToRingSlot = false;
+	if (safeToPush && _ringAvailable())	{
+		ringSlot = _ringSlotForPtr(inCPUBuffer->cpuBackingPtr);
+		if (ringSlot < 0 && _ensureRing(inCPUBuffer->calculateBackingLength(), createInCurrentContext))	{
+			ringSlot = _claimRingSlot();
+			copyToRingSlot = (ringSlot >= 0);
+		}
+	}
+	bool			useRing = (ringSlot >= 0);
+	
 	//	if we're safe to push, we need to create a PBO and a texture for the CPU buffer
 	GLBufferRef		inPBOBuffer = nullptr;
-	if (safeToPush)	{
+	if (safeToPush && !useRing)	{
 		switch (inCPUBuffer->desc.pixelFormat)	{
 		case GLBuffer::PF_RGBA:
 			if (inCPUBuffer->desc.pixelType == GLBuffer::PT_Float)	{
@@ -496,6 +1061,7 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 					bp);
 			}
 			break;
+#if !defined(VVGL_TARGETENV_GLES3)
 		case GLBuffer::PF_YCbCr_422:
 			inPBOBuffer = CreateYCbCrPBO(
 				GLBuffer::Target_PBOUnpack,
@@ -509,6 +1075,7 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 				createInCurrentContext,
 				bp);
 			break;
+#endif
 		default:
 			break;
 		}
@@ -525,21 +1092,41 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 	
 	//	pop buffers off the queues if appropriate
 	if (safeToPop)	{
-		GLBufferRef		outCPUBuffer = _cpuQueue.front();
+		//	the upload to the texture was started when it was pushed- popping it just hands the texture off
+		_measureTransfers();
 		_cpuQueue.pop();
-		GLBufferRef		outPBOBuffer = _pboQueue.front();
 		_pboQueue.pop();
 		returnMe = _texQueue.front();
 		_texQueue.pop();
-		_finishProcessing(outCPUBuffer, outPBOBuffer, returnMe);
+		GLsync			outFence = _fenceQueue.front();
+		_fenceQueue.pop_front();
+		
+		//	without a fence there's no way to tell when the upload completed, so it isn't timed
+		if (outFence == nullptr)
+			_adaptiveDepth.noteDrop();
+		else	{
+			//	if the upload hadn't completed when we popped it, whatever uses the texture will have to wait for it
+			_adaptiveDepth.notePop(!_adaptiveDepth.isComplete(0));
+			glDeleteSync(outFence);
+			GLERRLOG
+		}
 	}
-	//	push the buffer if appropriate
+	//	push the buffer if appropriate, and start uploading it to the texture (buffers uploaded via the ring have a null PBO).  the fence follows the upload, so the queue is timed by how long the texture takes to upload.
 	if (safeToPush)	{
 		_cpuQueue.push(inCPUBuffer);
 		_pboQueue.push(inPBOBuffer);
 		_texQueue.push(inTexBuffer);
-		_beginProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer);
+		if (useRing)
+			_fenceQueue.push_back(_beginRingProcessing(inCPUBuffer, inTexBuffer, ringSlot, copyToRingSlot));
+		else	{
+			_beginProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer);
+			_fenceQueue.push_back(_finishProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer, true));
+		}
+		_adaptiveDepth.noteSubmission();
 	}
+	//	if the queue size is adaptive, the pop may have changed it
+	if (safeToPop)
+		_applyAdaptiveDepth();
 	
 	return returnMe;
 }
@@ -550,4 +1137,4 @@ GLBufferRef GLCPUToTexCopier::streamCPUToTex(const GLBufferRef & inCPUBuffer, co
 
 
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
@@ -1,5 +1,9 @@
 #include "GLScene.hpp"
 
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
 
 
 
@@ -206,6 +210,10 @@ void GLScene::renderBlackFrame(const RenderTarget & inRenderTarget)	{
 	}
 	_context->makeCurrentIfNotCurrent();
 	
+	//	if the target is a plain texture we can clear it directly, skipping the program/viewport/clear render pass
+	if (_clearWithoutDraw(inRenderTarget, GLColor(0., 0., 0., 0.)))
+		return;
+	
 	//	update the member var for the fbo attachments
 	_renderTarget = inRenderTarget;
 	//	prep for render
@@ -237,6 +245,10 @@ void GLScene::renderOpaqueBlackFrame(const RenderTarget & inRenderTarget)	{
 	}
 	_context->makeCurrentIfNotCurrent();
 	
+	//	if the target is a plain texture we can clear it directly, skipping the program/viewport/clear render pass
+	if (_clearWithoutDraw(inRenderTarget, GLColor(0., 0., 0., 1.)))
+		return;
+	
 	//	update the member var for the fbo attachments
 	_renderTarget = inRenderTarget;
 	//	prep for render
@@ -268,6 +280,10 @@ void GLScene::renderRedFrame(const RenderTarget & inRenderTarget)	{
 	}
 	_context->makeCurrentIfNotCurrent();
 	
+	//	if the target is a plain texture we can clear it directly, skipping the program/viewport/clear render pass
+	if (_clearWithoutDraw(inRenderTarget, GLColor(1., 0., 0., 1.)))
+		return;
+	
 	//	update the member var for the fbo attachments
 	_renderTarget = inRenderTarget;
 	//	prep for render
@@ -492,8 +508,17 @@ void GLScene::_renderPrep()	{
 			_errDict.clear();
 		}
 		
+		//	if there's a cached binary of this program we don't need to compile or link anything
+		uint64_t		binaryCheck = 0;
+		string			binaryPath = _programBinaryCachePath(binaryCheck);
+		bool			loadedBinary = (binaryPath.size()>0 && _loadProgramBinary(binaryPath, binaryCheck));
+		if (loadedBinary)	{
+			_programReady = true;
+			_orthoUni.cacheTheLoc(_program);
+		}
+		
 		bool			encounteredError = false;
-		if (_vsString!=nullptr && _vsString->size() > 0)	{
+		if (!loadedBinary && _vsString!=nullptr && _vsString->size() > 0)	{
 			_vs = glCreateShader(GL_VERTEX_SHADER);
 			GLERRLOG
 			const char		*shaderSrc = _vsString->c_str();
@@ -530,7 +555,7 @@ void GLScene::_renderPrep()	{
 				_vs = 0;
 			}
 		}
-		if (_gsString!=nullptr && _gsString->size() > 0)	{
+		if (!loadedBinary && _gsString!=nullptr && _gsString->size() > 0)	{
 #if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
 			_gs = glCreateShader(GL_GEOMETRY_SHADER);
 			GLERRLOG
@@ -569,7 +594,7 @@ void GLScene::_renderPrep()	{
 			}
 #endif
 		}
-		if (_fsString!=nullptr && _fsString->size() > 0)	{
+		if (!loadedBinary && _fsString!=nullptr && _fsString->size() > 0)	{
 			_fs = glCreateShader(GL_FRAGMENT_SHADER);
 			GLERRLOG
 			const char		*shaderSrc = _fsString->c_str();
@@ -609,6 +634,13 @@ void GLScene::_renderPrep()	{
 		if ((_vs>0 || _gs>0 || _fs>0) && !encounteredError)	{
 			_program = glCreateProgram();
 			GLERRLOG
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+			//	many drivers only keep a retrievable binary if they're asked to before the program is linked
+			if (binaryPath.size() > 0)	{
+				glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+				GLERRLOG
+			}
+#endif
 			if (_vs > 0)	{
 				glAttachShader(_program, _vs);
 				GLERRLOG
@@ -679,6 +711,8 @@ void GLScene::_renderPrep()	{
 			else	{
 				_programReady = true;
 				_orthoUni.cacheTheLoc(_program);
+				if (binaryPath.size() > 0)
+					_saveProgramBinary(binaryPath, binaryCheck);
 			}
 		}
 		
@@ -905,6 +939,265 @@ void GLScene::_renderCleanup()	{
 	if (_renderCleanupCallback != nullptr)
 		_renderCleanupCallback(*this);
 }
+bool GLScene::_canClearWithoutDraw(const GLBufferRef & n)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	if (n==nullptr || _context==nullptr)
+		return false;
+	if (n->desc.type!=GLBuffer::Type_Tex || n->name==0)
+		return false;
+	//	integer and YCbCr textures can't be cleared with float color values
+	if (n->desc.pixelFormat!=GLBuffer::PF_RGBA && n->desc.pixelFormat!=GLBuffer::PF_BGRA)
+		return false;
+	GLVersion			myVers = glVersion();
+	return (myVers==GLVersion_33 || myVers==GLVersion_4 || myVers==GLVersion_ES3);
+#else
+	return false;
+#endif
+}
+void GLScene::_clearTextures(const vector<GLBufferRef> & inTexs, const GLColor & inColor, const GLBufferRef & inFBO, const GLBufferRef & inDepth)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	if (inTexs.size()==0 && inDepth==nullptr)
+		return;
+	const GLfloat		color[4] = { inColor.r, inColor.g, inColor.b, inColor.a };
+	const GLfloat		depth = 1.;
+	
+	//	GL 4.4 can clear a texture directly- no FBO, no attachment changes, no framebuffer completeness check
+#if defined(VVGL_SDK_GLFW) || defined(VVGL_SDK_QT) || defined(VVGL_SDK_WIN)
+	if (inDepth==nullptr && glVersion()==GLVersion_4 && (GLEW_VERSION_4_4 || GLEW_ARB_clear_texture))	{
+		for (const auto & tex : inTexs)	{
+			glClearTexImage(tex->name, 0, GL_RGBA, GL_FLOAT, color);
+			GLERRLOG
+		}
+		glFlush();
+		GLERRLOG
+		return;
+	}
+#endif
+	
+	//	otherwise bind the FBO once and swap the color attachment for each texture- glClearBufferfv() doesn't touch the clear color or any other state
+	if (inFBO == nullptr)
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, inFBO->name);
+	GLERRLOG
+	if (inDepth != nullptr)	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, inDepth->desc.target, inDepth->name, 0);
+		GLERRLOG
+		glClearBufferfv(GL_DEPTH, 0, &depth);
+		GLERRLOG
+	}
+	else	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+		GLERRLOG
+	}
+	for (const auto & tex : inTexs)	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->desc.target, tex->name, 0);
+		GLERRLOG
+		glClearBufferfv(GL_COLOR, 0, color);
+		GLERRLOG
+	}
+	glFlush();
+	GLERRLOG
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLERRLOG
+#else
+	//	GL2/ES2 have no way to clear a texture without going through glClear(), callers should have checked _canClearWithoutDraw()
+	(void)inTexs;
+	(void)inColor;
+	(void)inFBO;
+	(void)inDepth;
+#endif
+}
+bool GLScene::_clearWithoutDraw(const RenderTarget & inRenderTarget, const GLColor & inColor)	{
+	//	the default framebuffer (no FBO) has to be cleared the old-fashioned way
+	if (inRenderTarget.fboName()==0 || !_canClearWithoutDraw(inRenderTarget.color))
+		return false;
+	if (inRenderTarget.depth!=nullptr && (inRenderTarget.depth->desc.type!=GLBuffer::Type_Tex || inRenderTarget.depth->name==0))
+		return false;
+	if (_deleted)
+		return true;
+	
+	_clearTextures(vector<GLBufferRef>{ inRenderTarget.color }, inColor, inRenderTarget.fbo, inRenderTarget.depth);
+	return true;
+}
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- program binary cache
+
+
+static mutex		_globalProgramBinaryCacheLock;
+static string		_globalProgramBinaryCacheDir;
+
+void SetGlobalProgramBinaryCacheDir(const string & inDir)	{
+	lock_guard<mutex>		lock(_globalProgramBinaryCacheLock);
+	_globalProgramBinaryCacheDir = inDir;
+}
+string GetGlobalProgramBinaryCacheDir()	{
+	lock_guard<mutex>		lock(_globalProgramBinaryCacheLock);
+	return _globalProgramBinaryCacheDir;
+}
+
+//	64-bit FNV-1a across the passed strings (each followed by a null, so moving text between shaders changes the hash)- unlike std::hash this is stable across runs, builds and platforms
+static uint64_t ProgramBinaryHash(const vector<const char *> & inStrings, const uint64_t & inBasis)	{
+	uint64_t		returnMe = inBasis;
+	for (const auto & str : inStrings)	{
+		const unsigned char		*rPtr = reinterpret_cast<const unsigned char *>((str==nullptr) ? "" : str);
+		do	{
+			returnMe ^= static_cast<uint64_t>(*rPtr);
+			returnMe *= 1099511628211ULL;
+		} while (*(rPtr++) != 0);
+	}
+	return returnMe;
+}
+
+//	the file starts with this header, followed by 'length' bytes of program binary
+struct ProgramBinaryHeader	{
+	char			magic[8] = { 'V', 'V', 'G', 'L', 'P', 'G', 'M', '1' };
+	uint64_t		check = 0;
+	uint32_t		format = 0;
+	uint32_t		length = 0;
+};
+
+
+string GLScene::_programBinaryCachePath(uint64_t & outCheck)	{
+	outCheck = 0;
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	if (_renderPreLinkCallback != nullptr)
+		return string("");
+	string			dir = GetGlobalProgramBinaryCacheDir();
+	if (dir.size() == 0)
+		return string("");
+	GLVersion		myVers = glVersion();
+	if (myVers!=GLVersion_33 && myVers!=GLVersion_4 && myVers!=GLVersion_ES3)
+		return string("");
+#if defined(VVGL_SDK_GLFW) || defined(VVGL_SDK_QT) || defined(VVGL_SDK_WIN)
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+		return string("");
+#endif
+	GLint			numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	GLERRLOG
+	if (numFormats <= 0)
+		return string("");
+	
+	//	binaries are only valid for the driver that made them, so the renderer and version strings are part of the key
+	const char		*renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+	GLERRLOG
+	const char		*version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+	GLERRLOG
+	vector<const char *>		keyStrings = {
+		renderer,
+		version,
+		(_vsString==nullptr) ? nullptr : _vsString->c_str(),
+		(_gsString==nullptr) ? nullptr : _gsString->c_str(),
+		(_fsString==nullptr) ? nullptr : _fsString->c_str()
+	};
+	uint64_t		key = ProgramBinaryHash(keyStrings, 14695981039346656037ULL);
+	outCheck = ProgramBinaryHash(keyStrings, 0x84222325cbf29ce4ULL);
+	
+	char			keyStr[17];
+	snprintf(keyStr, sizeof(keyStr), "%016llx", static_cast<unsigned long long>(key));
+	char			lastChar = dir[dir.size()-1];
+	if (lastChar!='/' && lastChar!='\\')
+		dir += "/";
+	return dir + string(keyStr) + string(".vvglpgm");
+#else
+	return string("");
+#endif
+}
+bool GLScene::_loadProgramBinary(const string & inPath, const uint64_t & inCheck)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	ifstream			file(inPath, ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+	
+	ProgramBinaryHeader		expected;
+	ProgramBinaryHeader		header;
+	file.read(reinterpret_cast<char *>(&header), sizeof(header));
+	bool				valid = (file.good() && memcmp(header.magic, expected.magic, sizeof(header.magic))==0 && header.check==inCheck && header.length>0);
+	vector<char>		binary;
+	if (valid)	{
+		binary.resize(header.length);
+		file.read(binary.data(), header.length);
+		valid = file.good();
+	}
+	file.close();
+	if (!valid)	{
+		remove(inPath.c_str());
+		return false;
+	}
+	
+	_program = glCreateProgram();
+	GLERRLOG
+	glProgramBinary(_program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+	//	don't log errors here- a driver update makes the old format invalid, which is expected and handled by recompiling
+	glGetError();
+	int32_t				linked = 0;
+	glGetProgramiv(_program, GL_LINK_STATUS, &linked);
+	GLERRLOG
+	if (!linked)	{
+		glDeleteProgram(_program);
+		GLERRLOG
+		_program = 0;
+		remove(inPath.c_str());
+		return false;
+	}
+	return true;
+#else
+	(void)inPath;
+	(void)inCheck;
+	return false;
+#endif
+}
+void GLScene::_saveProgramBinary(const string & inPath, const uint64_t & inCheck)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	if (_program == 0)
+		return;
+	GLint				length = 0;
+	glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+	GLERRLOG
+	if (length <= 0)
+		return;
+	
+	ProgramBinaryHeader		header;
+	vector<char>		binary(static_cast<size_t>(length));
+	GLsizei				written = 0;
+	GLenum				format = 0;
+	glGetProgramBinary(_program, length, &written, &format, binary.data());
+	GLERRLOG
+	if (written <= 0)
+		return;
+	header.check = inCheck;
+	header.format = static_cast<uint32_t>(format);
+	header.length = static_cast<uint32_t>(written);
+	
+	//	write to a temp file and rename it, so other scenes (or processes) never load a partial binary
+	char				suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%p.tmp", static_cast<void *>(this));
+	string				tmpPath = inPath + string(suffix);
+	{
+		ofstream			file(tmpPath, ios::out | ios::binary | ios::trunc);
+		if (!file.is_open())
+			return;
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(binary.data(), written);
+		if (!file.good())	{
+			file.close();
+			remove(tmpPath.c_str());
+			return;
+		}
+	}
+	if (rename(tmpPath.c_str(), inPath.c_str()) != 0)
+		remove(tmpPath.c_str());
+#else
+	(void)inPath;
+	(void)inCheck;
+#endif
+}
+
+
 
 
 }
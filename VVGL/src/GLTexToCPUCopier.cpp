@@ -1,10 +1,28 @@
 #include "GLTexToCPUCopier.hpp"
+#include "GLTexToTexCopier.hpp"
+#include "VVGL_RowCopy.hpp"
 
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <cmath>
 
 
 
-//	none of this stuff should be available if we're running ES
-#if !defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+
+//	none of this stuff should be available if we're running ES 2 (there are no PBOs)
+#if !defined(VVGL_TARGETENV_GLES)
+
+
+
+
+//	persistently-mapped buffers (ARB_buffer_storage/GL 4.4) aren't available on the mac- on the other 
+//	platforms we're using GLEW, so we can check for the extension at runtime.
+#if defined(VVGL_SDK_GLFW) || defined(VVGL_SDK_QT) || defined(VVGL_SDK_WIN)
+	#define PERSISTENTRING 1
+#else
+	#define PERSISTENTRING 0
+#endif
 
 
 
@@ -18,42 +36,430 @@ using namespace std;
 
 
 
+//	makes a pack PBO with the passed pixel format and dimensions (only the pixel formats the copier reads back are supported).  float PBOs are made for float textures, which are read back as floats.
+static GLBufferRef CreatePackPBO(const GLBuffer::PixelFormat & inPixelFormat, const bool & inFloat, const Size & inSize, const bool & createInCurrentContext, const GLBufferPoolRef & inPool)	{
+	switch (inPixelFormat)	{
+	case GLBuffer::PF_RGBA:
+		if (inFloat)
+			return CreateRGBAFloatPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inSize, nullptr, createInCurrentContext, inPool);
+		return CreateRGBAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inSize, nullptr, createInCurrentContext, inPool);
+	case GLBuffer::PF_BGRA:
+		if (inFloat)
+			return CreateBGRAFloatPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inSize, nullptr, createInCurrentContext, inPool);
+		return CreateBGRAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inSize, nullptr, createInCurrentContext, inPool);
+#if !defined(VVGL_TARGETENV_GLES3)
+	case GLBuffer::PF_YCbCr_422:
+		return CreateYCbCrPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inSize, nullptr, createInCurrentContext, inPool);
+#endif
+	default:
+		break;
+	}
+	return nullptr;
+}
+
+
+
+
+//	returns true if the passed fence has been signaled.  flushes the commands (so the fence will eventually be signaled) but never waits.
+static bool FenceSignaled(const GLsync & inFence)	{
+	GLenum			waitResult = glClientWaitSync(inFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	GLERRLOG
+	return (waitResult==GL_ALREADY_SIGNALED || waitResult==GL_CONDITION_SATISFIED);
+}
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- readback ring
+
+
+//	a single pack buffer, persistently mapped and split into slots.  slots are marked busy while a 
+//	download is in flight and while a CPU buffer that points into them exists- CPU buffers retain 
+//	the ring, so the PBO isn't deleted until the last of them has been freed.
+struct GLTexToCPUCopier::ReadbackRing	{
+	GLBufferRef			pbo = nullptr;	//	created by the pool, so the pool deletes it when the ring is freed
+	uint8_t				*ptr = nullptr;
+	GLBuffer::PixelFormat	pixelFormat = GLBuffer::PF_None;
+	Size				frameSize;
+	size_t				slotBytes = 0;
+	int					slotCount = 0;
+	
+	mutex				lock;	//	used to serialize access to 'busy' and 'nextSlot'
+	vector<bool>		busy;
+	int					nextSlot = 0;
+	
+	//	returns the index of a slot that isn't busy (and marks it busy), or -1 if every slot is busy
+	int claimSlot()	{
+		lock_guard<mutex>		tmpLock(lock);
+		for (int i=0; i<slotCount; ++i)	{
+			int			slot = (nextSlot + i) % slotCount;
+			if (!busy[static_cast<size_t>(slot)])	{
+				busy[static_cast<size_t>(slot)] = true;
+				nextSlot = (slot + 1) % slotCount;
+				return slot;
+			}
+		}
+		return -1;
+	}
+	void releaseSlot(const int & inSlot)	{
+		lock_guard<mutex>		tmpLock(lock);
+		if (inSlot>=0 && inSlot<slotCount)
+			busy[static_cast<size_t>(inSlot)] = false;
+	}
+	uint8_t * slotPtr(const int & inSlot) const { return ptr + (static_cast<size_t>(inSlot) * slotBytes); }
+};
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- async download worker
+
+
+//	finishes downloads on its own thread (with its own GL context) and delivers them to their callbacks
+struct GLTexToCPUCopier::AsyncDownloader	{
+	struct Job	{
+		PendingDownload			download;
+		DownloadCallback		callback;
+	};
+	
+	mutex					lock;
+	condition_variable		condition;
+	deque<Job>				jobs;
+	bool					quit = false;
+	GLContextRef			context = nullptr;
+	GLTexToCPUCopier		*copier = nullptr;	//	weak- the copier stops the worker before it's freed
+	thread					workerThread;
+	
+	AsyncDownloader(const GLContextRef & inCtx, GLTexToCPUCopier * inCopier) : context(inCtx), copier(inCopier)	{}
+	
+	void start()	{
+		workerThread = thread([this]()	{
+			run();
+		});
+	}
+	void addJob(Job && n)	{
+		{
+			lock_guard<mutex>		tmpLock(lock);
+			jobs.emplace_back(move(n));
+		}
+		condition.notify_one();
+	}
+	void stop()	{
+		{
+			lock_guard<mutex>		tmpLock(lock);
+			quit = true;
+		}
+		condition.notify_one();
+		if (workerThread.joinable())
+			workerThread.join();
+	}
+	void run()	{
+		context->makeCurrent();
+		//	jobs are finished in the order they were submitted (the GPU completes them in that order too), and every job is finished before the worker quits
+		while (true)	{
+			Job					job;
+			{
+				unique_lock<mutex>		tmpLock(lock);
+				condition.wait(tmpLock, [&]()	{ return (quit || jobs.size()>0); });
+				if (jobs.size() < 1)
+					return;
+				job = move(jobs.front());
+				jobs.pop_front();
+			}
+			
+			//	wait until the transfer has completed- the fence was flushed by the context that inserted it, so we don't need to flush here
+			if (job.download.fence != nullptr)	{
+				glClientWaitSync(job.download.fence, 0, GL_TIMEOUT_IGNORED);
+				GLERRLOG
+			}
+			GLBufferRef			result = copier->_finishDownload(job.download);
+			//	release the GL resources we don't need any more before calling the callback
+			job.download = PendingDownload();
+			if (job.callback != nullptr)
+				job.callback(result);
+		}
+	}
+};
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- constructor/destructor
+
+
 GLTexToCPUCopier::GLTexToCPUCopier()	{
 	GLBufferPoolRef		bp = GetGlobalBufferPool();
 	if (bp != nullptr)
 		_queueCtx = bp->context();
 }
 GLTexToCPUCopier::~GLTexToCPUCopier()	{
+	//	finish any async downloads (and call their callbacks) before we're freed
+	shared_ptr<AsyncDownloader>		worker = nullptr;
+	{
+		lock_guard<recursive_mutex>		lock(_queueLock);
+		worker = _asyncDownloader;
+		_asyncDownloader = nullptr;
+	}
+	if (worker != nullptr)
+		worker->stop();
+	
 	clearStream();
 }
 void GLTexToCPUCopier::clearStream()	{
 	lock_guard<recursive_mutex>		lock(_queueLock);
-	while (_cpuQueue.size() > 0)
-		_cpuQueue.pop();
-	while (_pboQueue.size() > 0)
-		_pboQueue.pop();
-	while (_texQueue.size() > 0)
-		_texQueue.pop();
-	while (_fboQueue.size() > 0)
-		_fboQueue.pop();
+	_makeQueueCtxCurrentForDrops();
+	_clearQueues();
 }
 void GLTexToCPUCopier::setQueueSize(const int & inNewQueueSize)	{
 	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
 	
 	_queueSize = inNewQueueSize;
 	if (_queueSize < 0)
 		_queueSize = 0;
 	
-	while (static_cast<int>(_cpuQueue.size()) > _queueSize)
-		_cpuQueue.pop();
+	//	a manually-set size is the adaptive mode's new starting point
+	_adaptiveDepth.setDepth(_queueSize);
+	
+	//	the queues only shrink by dropping their oldest entries
 	while (static_cast<int>(_pboQueue.size()) > _queueSize)
-		_pboQueue.pop();
-	while (static_cast<int>(_texQueue.size()) > _queueSize)
-		_texQueue.pop();
+		_dropDownload();
 }
+void GLTexToCPUCopier::setAdaptiveQueueSize(const bool & n)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveQueueSize = n;
+	if (_adaptiveQueueSize)	{
+		_adaptiveDepth.setDepth(_queueSize);
+		_applyAdaptiveDepth();
+	}
+}
+void GLTexToCPUCopier::setAdaptiveQueueLimits(const int & inMin, const int & inMax)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveDepth.setLimits(inMin, inMax);
+	_applyAdaptiveDepth();
+}
+void GLTexToCPUCopier::setTargetLatency(const double & inSeconds)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_makeQueueCtxCurrentForDrops();
+	_adaptiveDepth.setTargetLatency(inSeconds);
+	_applyAdaptiveDepth();
+}
+void GLTexToCPUCopier::setPersistentMapping(const bool & n)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	_persistentMapping = n;
+	//	downloads that are already in the ring finish normally- the copier just stops retaining it
+	if (!_persistentMapping)
+		_readbackRing = nullptr;
+}
+bool GLTexToCPUCopier::persistentMappingAvailable()	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	return _ringAvailable();
+}
+
 
+/*	========================================	*/
+#pragma mark --------------------- GPU conversion
 
-void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & inFBOBuffer)	{
+
+#if defined(VVGL_TARGETENV_GL3PLUS)
+//	indexes into '_converters'
+enum	{
+	ConverterIndex_BGRA8 = 0,
+	ConverterIndex_UYVY,
+	ConverterIndex_NV12Luma,
+	ConverterIndex_NV12Chroma
+};
+
+//	every conversion shader renders into an 8-bit RGBA texture.  pixelAt() samples the source at an offset (in source 
+//	pixels) from the fragment's position.  the YCbCr shaders use BT.709 video-range coefficients.
+static const string		ConverterFragHeader("\r\n\
+#version 330 core\r\n\
+in vec2		programST;\r\n\
+uniform sampler2D		inputImage;\r\n\
+uniform sampler2DRect	inputImageRect;\r\n\
+uniform int		isRectTex;\r\n\
+out vec4		FragColor;\r\n\
+vec4 pixelAt(float dx, float dy)	{\r\n\
+	if (isRectTex==1)\r\n\
+		return texture(inputImage, programST + vec2(dx,dy)/vec2(textureSize(inputImage,0)));\r\n\
+	else if (isRectTex==2)\r\n\
+		return texture(inputImageRect, programST + vec2(dx,dy));\r\n\
+	return vec4(0,0,0,1);\r\n\
+}\r\n\
+float lumaFor(vec4 c)	{\r\n\
+	return (16.0/255.0) + (219.0/255.0)*dot(clamp(c.rgb,0.0,1.0), vec3(0.2126,0.7152,0.0722));\r\n\
+}\r\n\
+vec2 chromaFor(vec4 c)	{\r\n\
+	vec3		rgb = clamp(c.rgb,0.0,1.0);\r\n\
+	float		y = dot(rgb, vec3(0.2126,0.7152,0.0722));\r\n\
+	return vec2(0.5) + (224.0/255.0)*vec2((rgb.b-y)/1.8556, (rgb.r-y)/1.5748);\r\n\
+}\r\n\
+");
+//	one output pixel per source pixel
+static const string		ConverterFragBGRA8("\r\n\
+void main()	{\r\n\
+	FragColor = clamp(pixelAt(0.0,0.0).bgra, 0.0, 1.0);\r\n\
+}\r\n\
+");
+//	one output pixel (Cb Y0 Cr Y1) per two source pixels
+static const string		ConverterFragUYVY("\r\n\
+void main()	{\r\n\
+	vec4		a = pixelAt(-0.5,0.0);\r\n\
+	vec4		b = pixelAt(0.5,0.0);\r\n\
+	vec2		cbcr = (chromaFor(a) + chromaFor(b)) * 0.5;\r\n\
+	FragColor = vec4(cbcr.x, lumaFor(a), cbcr.y, lumaFor(b));\r\n\
+}\r\n\
+");
+//	one output pixel (Y0 Y1 Y2 Y3) per four source pixels
+static const string		ConverterFragNV12Luma("\r\n\
+void main()	{\r\n\
+	FragColor = vec4(lumaFor(pixelAt(-1.5,0.0)), lumaFor(pixelAt(-0.5,0.0)), lumaFor(pixelAt(0.5,0.0)), lumaFor(pixelAt(1.5,0.0)));\r\n\
+}\r\n\
+");
+//	one output pixel (Cb0 Cr0 Cb1 Cr1) per 4x2 block of source pixels
+static const string		ConverterFragNV12Chroma("\r\n\
+vec2 blockChroma(float dx)	{\r\n\
+	return (chromaFor(pixelAt(dx-0.5,-0.5)) + chromaFor(pixelAt(dx+0.5,-0.5)) + chromaFor(pixelAt(dx-0.5,0.5)) + chromaFor(pixelAt(dx+0.5,0.5))) * 0.25;\r\n\
+}\r\n\
+void main()	{\r\n\
+	FragColor = vec4(blockChroma(-1.0), blockChroma(1.0));\r\n\
+}\r\n\
+");
+#endif
+
+
+bool GLTexToCPUCopier::_convertTex(const GLBufferRef & inTexBuffer, const Size & inOutputSize, GLBufferRef & outTexBuffer, GLBufferRef & outChromaBuffer)	{
+#if defined(VVGL_TARGETENV_GL3PLUS)
+	if (_downloadFormat==DownloadFormat_Native || inTexBuffer==nullptr || _queueCtx==nullptr)
+		return false;
+	if (_queueCtx->version!=GLVersion_33 && _queueCtx->version!=GLVersion_4)
+		return false;
+	
+	//	make sure the output dimensions suit the format
+	int				w = static_cast<int>(inOutputSize.width);
+	int				h = static_cast<int>(inOutputSize.height);
+	if (w<1 || h<1)
+		return false;
+	switch (_downloadFormat)	{
+	case DownloadFormat_UYVY:
+		if (w%2 != 0)
+			return false;
+		break;
+	case DownloadFormat_NV12:
+		if (w%4!=0 || h%2!=0)
+			return false;
+		break;
+	default:
+		break;
+	}
+	
+	//	the YCbCr shaders sample the source at fixed offsets (in source pixels) from each output pixel, so they need a source that's already the output size- if we're scaling the texture down, scale it first and convert the scaled texture
+	GLBufferRef			srcTex = inTexBuffer;
+	if (_downloadFormat!=DownloadFormat_BGRA8 && inTexBuffer->srcRect.size!=Size(w,h))	{
+		srcTex = _scaleTex(inTexBuffer, Size(w,h));
+		if (srcTex == nullptr)
+			return false;
+	}
+	
+	//	returns the converter at the passed index, creating it if necessary
+	auto			converterAt = [&](const int & inIndex, const string & inFragString)	{
+		GLTexToTexCopierRef		&converter = _converters[inIndex];
+		if (converter == nullptr)	{
+			converter = CreateGLTexToTexCopierRefUsing(_queueCtx);
+			converter->setPrivatePool(_privatePool);
+			converter->setFragmentShaderString(ConverterFragHeader + inFragString);
+			//	a blit would skip the conversion shader
+			converter->setFastCopy(false);
+		}
+		return converter;
+	};
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	GLBufferRef			lumaTex = nullptr;
+	GLBufferRef			chromaTex = nullptr;
+	switch (_downloadFormat)	{
+	case DownloadFormat_BGRA8:
+		lumaTex = CreateRGBATex(Size(w,h), false, bp);
+		if (lumaTex != nullptr)
+			converterAt(ConverterIndex_BGRA8, ConverterFragBGRA8)->sizeVariantCopy(srcTex, lumaTex);
+		break;
+	case DownloadFormat_UYVY:
+		lumaTex = CreateRGBATex(Size(w/2,h), false, bp);
+		if (lumaTex != nullptr)
+			converterAt(ConverterIndex_UYVY, ConverterFragUYVY)->sizeVariantCopy(srcTex, lumaTex);
+		break;
+	case DownloadFormat_NV12:
+		lumaTex = CreateRGBATex(Size(w/4,h), false, bp);
+		chromaTex = CreateRGBATex(Size(w/4,h/2), false, bp);
+		if (lumaTex==nullptr || chromaTex==nullptr)
+			return false;
+		converterAt(ConverterIndex_NV12Luma, ConverterFragNV12Luma)->sizeVariantCopy(srcTex, lumaTex);
+		converterAt(ConverterIndex_NV12Chroma, ConverterFragNV12Chroma)->sizeVariantCopy(srcTex, chromaTex);
+		chromaTex->contentTimestamp = inTexBuffer->contentTimestamp;
+		break;
+	default:
+		break;
+	}
+	if (lumaTex == nullptr)
+		return false;
+	
+	//	the converted textures aren't flipped (the conversion un-flips them), but they have the source's timestamp
+	lumaTex->contentTimestamp = inTexBuffer->contentTimestamp;
+	outTexBuffer = lumaTex;
+	outChromaBuffer = chromaTex;
+	return true;
+#else
+	(void)inTexBuffer;
+	(void)inOutputSize;
+	(void)outTexBuffer;
+	(void)outChromaBuffer;
+	return false;
+#endif
+}
+
+
+GLBufferRef GLTexToCPUCopier::_scaleTex(const GLBufferRef & inTexBuffer, const Size & inOutputSize)	{
+	if (inTexBuffer==nullptr || _queueCtx==nullptr)
+		return nullptr;
+	
+	//	the scaled texture has the same precision as the source (YCbCr textures can't be filtered, so they aren't scaled)
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	GLBufferRef			returnMe = nullptr;
+	switch (inTexBuffer->desc.pixelFormat)	{
+	case GLBuffer::PF_RGBA:
+	case GLBuffer::PF_BGRA:
+		returnMe = (inTexBuffer->desc.pixelType == GLBuffer::PT_Float)
+			? CreateRGBAFloatTex(inOutputSize, false, bp)
+			: CreateRGBATex(inOutputSize, false, bp);
+		break;
+	default:
+		break;
+	}
+	if (returnMe == nullptr)
+		return nullptr;
+	
+	if (_scaler == nullptr)	{
+		_scaler = CreateGLTexToTexCopierRefUsing(_queueCtx);
+		_scaler->setPrivatePool(_privatePool);
+	}
+	_scaler->sizeVariantCopy(inTexBuffer, returnMe);
+	
+	//	the scaled texture isn't flipped (the copy un-flips it), but it has the source's timestamp
+	returnMe->contentTimestamp = inTexBuffer->contentTimestamp;
+	return returnMe;
+}
+
+
+/*	========================================	*/
+#pragma mark --------------------- processing
+
+
+GLsync GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & inFBOBuffer, const bool & inFence, const size_t & inPBOOffset)	{
 	/*
 	cout << __FUNCTION__ << endl;
 	if (inCPUBuffer == nullptr)
@@ -73,7 +479,7 @@ void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, con
 	*/
 	//	the CPU buffer may be null, but not the PBO nor texture
 	if (inPBOBuffer==nullptr || inTexBuffer==nullptr)
-		return;
+		return nullptr;
 	
 	
 	
@@ -96,7 +502,7 @@ void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, con
 	//GLERRLOG
 	
 	//	set up some pixel transfer modes
-	glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<int>(inPBOBuffer->size.width));
+	glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<int>(inTexBuffer->srcRect.size.width));
 	GLERRLOG
 	
 	//	start packing the texture data into the pbo
@@ -108,14 +514,15 @@ void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, con
 	//	NULL
 	//	);
 	//GLERRLOG
+	//	only the texture's srcRect is read
 	glReadPixels(
-		0,
-		0,
-		static_cast<int>(inPBOBuffer->size.width),
-		static_cast<int>(inPBOBuffer->size.height),
+		static_cast<int>(inTexBuffer->srcRect.origin.x),
+		static_cast<int>(inTexBuffer->srcRect.origin.y),
+		static_cast<int>(inTexBuffer->srcRect.size.width),
+		static_cast<int>(inTexBuffer->srcRect.size.height),
 		inTexBuffer->desc.pixelFormat,
 		inTexBuffer->desc.pixelType,
-		nullptr
+		reinterpret_cast<GLvoid*>(inPBOOffset)
 		);
 	GLERRLOG
 	
@@ -127,7 +534,19 @@ void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, con
 	glBindBuffer(inPBOBuffer->desc.target, 0);
 	GLERRLOG
 	
-	//	flush- this starts the DMA transfer.  the CPU won't wait for this transfer to complete, and will return execution immediately.
+	//	insert a fence after the read- it's signaled when the transfer into the PBO has completed, so we can tell when the PBO can be mapped without stalling
+	GLsync			returnMe = nullptr;
+	if (inFence)	{
+		GLContextRef	ctx = _queueCtx;
+		if (ctx==nullptr && inPBOBuffer->parentBufferPool!=nullptr)
+			ctx = inPBOBuffer->parentBufferPool->context();
+		if (ctx!=nullptr && (ctx->version==GLVersion_33 || ctx->version==GLVersion_4 || ctx->version==GLVersion_ES3))	{
+			returnMe = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			GLERRLOG
+		}
+	}
+	
+	//	flush- this starts the DMA transfer (and submits the fence).  the CPU won't wait for this transfer to complete, and will return execution immediately.
 	glFlush();
 	GLERRLOG
 	
@@ -138,6 +557,8 @@ void GLTexToCPUCopier::_beginProcessing(const GLBufferRef & /*inCPUBuffer*/, con
 	*/
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	GLERRLOG
+	
+	return returnMe;
 }
 void GLTexToCPUCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const GLBufferRef & inPBOBuffer, const GLBufferRef & inTexBuffer, const GLBufferRef & /*inFBOBuffer*/)	{
 	/*
@@ -164,28 +585,9 @@ void GLTexToCPUCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 	inPBOBuffer->mapPBO(GL_READ_ONLY, true);
 	//	if we mapped the PBO and got a valid cpu backing...
 	if (inPBOBuffer->pboMapped && inPBOBuffer->cpuBackingPtr!=nullptr)	{
-		//	if the CPU buffer is non-null, copy the contents of the PBO to the CPU buffer.
-		if (inCPUBuffer != nullptr)	{
-			size_t		cpuBPR = inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inCPUBuffer->size.width));
-			size_t		pboBPR = inPBOBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inPBOBuffer->size.width));
-			uint8_t		*rPtr = static_cast<uint8_t*>(inPBOBuffer->cpuBackingPtr);
-			uint8_t		*wPtr = static_cast<uint8_t*>(inCPUBuffer->cpuBackingPtr);
-	
-			//	if the cpu buffer's bytes per row differs from the PBO's bytes per row, we have to copy one row at a time
-			if (cpuBPR != pboBPR)	{
-				size_t		copyBytesPerRow = (cpuBPR<pboBPR) ? cpuBPR : pboBPR;
-				for (int i=0; i<inPBOBuffer->size.height; ++i)	{
-					memcpy(wPtr, rPtr, copyBytesPerRow);
-					wPtr += cpuBPR;
-					rPtr += pboBPR;
-				}
-			}
-			//	else the CPU buffer and the PBO have the same exact number of bytes per row- we can copy their contents in a single call
-			else	{
-				memcpy(wPtr, rPtr, pboBPR * static_cast<size_t>(inPBOBuffer->size.height));
-			}
-	
-		}
+		//	if the CPU buffer is non-null, copy the contents of the PBO to the CPU buffer (converting the pixels if the CPU buffer's format differs).
+		if (inCPUBuffer != nullptr)
+			CopyBufferRows(inPBOBuffer, inCPUBuffer);
 	}
 	
 	//	...do not un-map the PBO- leave it mapped (the buffer pool will unmap it before releasing it 
@@ -209,9 +611,364 @@ void GLTexToCPUCopier::_finishProcessing(const GLBufferRef & inCPUBuffer, const
 	inPBOBuffer->flipped = inTexBuffer->flipped;
 	inPBOBuffer->contentTimestamp = inTexBuffer->contentTimestamp;
 }
+GLBufferRef GLTexToCPUCopier::_finishRingProcessing(const GLBufferRef & inCPUBuffer, const shared_ptr<ReadbackRing> & inRing, const int & inSlot, const GLBufferRef & inTexBuffer, const GLBufferPoolRef & inPool)	{
+	//	the ring we're finishing may not be '_readbackRing' any more (it's replaced if the texture dimensions or queue size change)
+	shared_ptr<ReadbackRing>		ring = inRing;
+	if (ring==nullptr || inTexBuffer==nullptr)
+		return nullptr;
+	
+	uint8_t			*slotPtr = ring->slotPtr(inSlot);
+	GLBufferRef		returnMe = nullptr;
+	//	if there's a CPU buffer, copy the slot's contents to it and release the slot immediately
+	if (inCPUBuffer != nullptr)	{
+		RowCopyConversion	conversion = RowCopyConversionForDescriptors(ring->pbo->desc, inCPUBuffer->desc);
+		size_t		cpuBPR = inCPUBuffer->desc.bytesPerRowForWidth(static_cast<uint32_t>(inCPUBuffer->size.width));
+		size_t		ringBPR = ring->pbo->desc.bytesPerRowForWidth(static_cast<uint32_t>(ring->frameSize.width));
+		size_t		rowCount = static_cast<size_t>(min(ring->frameSize.height, inCPUBuffer->size.height));
+		size_t		rowBytes = (conversion==RowCopyConversion_None)
+			? min(cpuBPR, ringBPR)
+			: ring->pbo->desc.bytesPerRowForWidth(static_cast<uint32_t>(min(ring->frameSize.width, inCPUBuffer->size.width)));
+		CopyRows(slotPtr, ringBPR, inCPUBuffer->cpuBackingPtr, cpuBPR, rowBytes, rowCount, conversion);
+		ring->releaseSlot(inSlot);
+		returnMe = inCPUBuffer;
+	}
+	//	else make a CPU buffer that points into the slot- it retains the ring, and releases the slot when it's freed
+	else	{
+		GLBufferPoolRef		bp = (inPool!=nullptr) ? inPool : GetGlobalBufferPool();
+		int					slot = inSlot;
+		GLBuffer::BackingReleaseCallback	releaseCallback = [ring,slot](GLBuffer & /*inBuffer*/, void * /*inContext*/)	{
+			ring->releaseSlot(slot);
+		};
+		switch (ring->pixelFormat)	{
+		case GLBuffer::PF_RGBA:
+			returnMe = CreateRGBACPUBufferUsing(ring->frameSize, slotPtr, ring->frameSize, nullptr, releaseCallback, bp);
+			break;
+		case GLBuffer::PF_BGRA:
+			returnMe = CreateBGRACPUBufferUsing(ring->frameSize, slotPtr, ring->frameSize, nullptr, releaseCallback, bp);
+			break;
+#if !defined(VVGL_TARGETENV_GLES3)
+		case GLBuffer::PF_YCbCr_422:
+			returnMe = CreateYCbCrCPUBufferUsing(ring->frameSize, slotPtr, ring->frameSize, nullptr, releaseCallback, bp);
+			break;
+#endif
+		default:
+			break;
+		}
+		if (returnMe == nullptr)	{
+			ring->releaseSlot(inSlot);
+			return nullptr;
+		}
+	}
+	
+	//	make sure the returned buffer inherits the texture's flippedness...
+	returnMe->flipped = inTexBuffer->flipped;
+	returnMe->contentTimestamp = inTexBuffer->contentTimestamp;
+	return returnMe;
+}
+bool GLTexToCPUCopier::_ringAvailable()	{
+#if PERSISTENTRING
+	if (!_persistentMapping || _queueCtx==nullptr)
+		return false;
+	if (_queueCtx->version!=GLVersion_33 && _queueCtx->version!=GLVersion_4)
+		return false;
+	return (GLEW_ARB_buffer_storage) ? true : false;
+#else
+	return false;
+#endif
+}
+bool GLTexToCPUCopier::_ensureRing(const GLBuffer::PixelFormat & inPixelFormat, const Size & inSize, const bool & createInCurrentContext)	{
+#if PERSISTENTRING
+	//	the ring is sized for the largest queue the adaptive mode may choose, so it doesn't have to be recreated when the queue size changes
+	int			maxQueueSize = (_adaptiveQueueSize) ? max(_queueSize, _adaptiveDepth.maxDepth()) : _queueSize;
+	int			slotCount = maxQueueSize + 3;
+	//	if the ring already exists and matches the download, we're done
+	if (_readbackRing!=nullptr && _readbackRing->pixelFormat==inPixelFormat && _readbackRing->frameSize==inSize && _readbackRing->slotCount==slotCount)
+		return true;
+	
+	//	release the old ring- any downloads in flight or CPU buffers that point into it keep it alive
+	_readbackRing = nullptr;
+	
+	//	the ring's PBO is made by the pool (so the pool accounts for it and deletes it), and then its storage is made immutable and persistently mapped
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	Size				ringSize(inSize.width, inSize.height * slotCount);
+	GLBufferRef			ringPBO = CreatePackPBO(inPixelFormat, false, ringSize, createInCurrentContext, bp);
+	if (ringPBO == nullptr)
+		return false;
+	//	immutable storage can't be recycled by the pool
+	ringPBO->preferDeletion = true;
+	
+	GLbitfield		flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr		totalBytes = static_cast<GLsizeiptr>(ringPBO->desc.backingLengthForSize(ringSize));
+	glBindBuffer(ringPBO->desc.target, ringPBO->name);
+	GLERRLOG
+	glBufferStorage(ringPBO->desc.target, totalBytes, nullptr, flags);
+	GLERRLOG
+	void			*ringPtr = glMapBufferRange(ringPBO->desc.target, 0, totalBytes, flags);
+	GLERRLOG
+	glBindBuffer(ringPBO->desc.target, 0);
+	GLERRLOG
+	//	deleting the buffer unmaps it, so the pool doesn't need to know that it's mapped
+	if (ringPtr == nullptr)	{
+		cout << "\tERR: couldnt map persistent PBO in " << __PRETTY_FUNCTION__ << endl;
+		return false;
+	}
+	
+	_readbackRing = make_shared<ReadbackRing>();
+	_readbackRing->pbo = ringPBO;
+	_readbackRing->ptr = static_cast<uint8_t*>(ringPtr);
+	_readbackRing->pixelFormat = inPixelFormat;
+	_readbackRing->frameSize = inSize;
+	_readbackRing->slotBytes = ringPBO->desc.backingLengthForSize(inSize);
+	_readbackRing->slotCount = slotCount;
+	_readbackRing->busy.resize(static_cast<size_t>(slotCount), false);
+	return true;
+#else
+	(void)inPixelFormat;
+	(void)inSize;
+	(void)createInCurrentContext;
+	return false;
+#endif
+}
+bool GLTexToCPUCopier::_startDownload(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext, PendingDownload & outDownload, const Rect & inRegion, const Size & inOutputSize)	{
+	if (inTexBuffer == nullptr)
+		return false;
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	
+	//	work out which region of the texture we're downloading (clipped to whole pixels within the texture)...
+	Rect				region = (inRegion.size.width>0. && inRegion.size.height>0.) ? inRegion : inTexBuffer->srcRect;
+	double				minX = fmax(0., floor(region.minX()));
+	double				minY = fmax(0., floor(region.minY()));
+	double				maxX = fmin(inTexBuffer->size.width, ceil(region.maxX()));
+	double				maxY = fmin(inTexBuffer->size.height, ceil(region.maxY()));
+	if (maxX<=minX || maxY<=minY)
+		return false;
+	region = Rect(minX, minY, maxX-minX, maxY-minY);
+	//	...and how large the download will be (downloads are only ever scaled down)
+	Size				outputSize = region.size;
+	if (inOutputSize.width>0. && inOutputSize.height>0. && (inOutputSize.width<region.size.width || inOutputSize.height<region.size.height))	{
+		outputSize.width = fmax(1., round(fmin(inOutputSize.width, region.size.width)));
+		outputSize.height = fmax(1., round(fmin(inOutputSize.height, region.size.height)));
+	}
+	
+	//	if the region isn't the texture's srcRect, work with a copy of the texture that describes the region
+	GLBufferRef			srcTex = inTexBuffer;
+	if (region != inTexBuffer->srcRect)	{
+		srcTex = GLBufferCopy(inTexBuffer);
+		if (srcTex == nullptr)
+			return false;
+		srcTex->srcRect = region;
+	}
+	
+	//	if appropriate, convert (and scale) the texture on the GPU- we read back the converted texture(s) instead, into a PBO that describes the download format
+	GLBufferRef			readTex = srcTex;
+	GLBufferRef			chromaTex = nullptr;
+	GLBuffer::PixelFormat	pboFormat = srcTex->desc.pixelFormat;
+	bool				pboFloat = (srcTex->desc.pixelType == GLBuffer::PT_Float);
+	Size				pboSize = region.size;
+	if (!createInCurrentContext && _convertTex(srcTex, outputSize, readTex, chromaTex))	{
+		pboFloat = false;
+		switch (_downloadFormat)	{
+		case DownloadFormat_BGRA8:
+			pboFormat = GLBuffer::PF_BGRA;
+			pboSize = readTex->size;
+			break;
+#if !defined(VVGL_TARGETENV_GLES3)
+		case DownloadFormat_UYVY:
+			pboFormat = GLBuffer::PF_YCbCr_422;
+			pboSize = Size(readTex->size.width*2., readTex->size.height);
+			break;
+#endif
+		case DownloadFormat_NV12:
+			//	the Y plane followed by the CbCr plane, both 'width' bytes per row
+			pboFormat = GLBuffer::PF_RGBA;
+			pboSize = Size(readTex->size.width, readTex->size.height + chromaTex->size.height);
+			break;
+		default:
+			break;
+		}
+	}
+	//	else if we're scaling the region down, render it into a smaller texture and read that back instead
+	else if (!createInCurrentContext && outputSize!=region.size)	{
+		GLBufferRef			scaledTex = _scaleTex(srcTex, outputSize);
+		if (scaledTex != nullptr)	{
+			readTex = scaledTex;
+			pboFormat = scaledTex->desc.pixelFormat;
+			pboFloat = (scaledTex->desc.pixelType == GLBuffer::PT_Float);
+			pboSize = scaledTex->size;
+		}
+	}
+	size_t				chromaOffset = (chromaTex==nullptr) ? 0 : readTex->desc.backingLengthForSize(readTex->size);
+	
+	//	make an FBO- we need to attach the texture we want to download to this.
+	GLBufferRef		tmpFBO = CreateFBO(createInCurrentContext, bp);
+	
+	outDownload.cpu = inCPUBuffer;
+	outDownload.tex = readTex;
+	outDownload.fbo = tmpFBO;
+	outDownload.pool = bp;
+	
+	//	reads the texture(s) into the passed PBO at the passed offset, and returns the fence for the last read
+	auto			beginReads = [&](const GLBufferRef & inPBO, const size_t & inOffset)	{
+		if (chromaTex != nullptr)
+			_beginProcessing(inCPUBuffer, inPBO, chromaTex, tmpFBO, false, inOffset + chromaOffset);
+		return _beginProcessing(inCPUBuffer, inPBO, readTex, tmpFBO, true, inOffset);
+	};
+	
+	//	if the ring's available and has a free slot, download the texture into the slot (the ring only holds 8-bit downloads)
+	if (!pboFloat && _ringAvailable() && tmpFBO!=nullptr && _ensureRing(pboFormat, pboSize, createInCurrentContext))	{
+		int				slot = _readbackRing->claimSlot();
+		if (slot >= 0)	{
+			outDownload.pbo = _readbackRing->pbo;
+			outDownload.ring = _readbackRing;
+			outDownload.slot = slot;
+			outDownload.fence = beginReads(_readbackRing->pbo, static_cast<size_t>(slot) * _readbackRing->slotBytes);
+			return true;
+		}
+	}
+	
+	//	make a PBO to download the texture into
+	GLBufferRef		inPBOBuffer = CreatePackPBO(pboFormat, pboFloat, pboSize, createInCurrentContext, bp);
+	
+	if (inPBOBuffer==nullptr || tmpFBO==nullptr)	{
+		cout << "\tERR: couldnt make PBO, " << __PRETTY_FUNCTION__ << endl;
+		return false;
+	}
+	
+	outDownload.pbo = inPBOBuffer;
+	outDownload.fence = beginReads(inPBOBuffer, 0);
+	return true;
+}
+GLBufferRef GLTexToCPUCopier::_finishDownload(PendingDownload & inDownload)	{
+	if (inDownload.fence != nullptr)	{
+		//	the ring is never mapped or unmapped, so the fence is the only thing that makes sure the transfer has completed before we read it
+		if (inDownload.slot >= 0)	{
+			glClientWaitSync(inDownload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			GLERRLOG
+		}
+		glDeleteSync(inDownload.fence);
+		GLERRLOG
+		inDownload.fence = nullptr;
+	}
+	
+	if (inDownload.slot >= 0)
+		return _finishRingProcessing(inDownload.cpu, inDownload.ring, inDownload.slot, inDownload.tex, inDownload.pool);
+	
+	_finishProcessing(inDownload.cpu, inDownload.pbo, inDownload.tex, inDownload.fbo);
+	if (inDownload.cpu != nullptr)
+		return inDownload.cpu;
+	return inDownload.pbo;
+}
+bool GLTexToCPUCopier::_pushDownload(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext, const Rect & inRegion, const Size & inOutputSize)	{
+	PendingDownload		download;
+	if (!_startDownload(inTexBuffer, inCPUBuffer, createInCurrentContext, download, inRegion, inOutputSize))
+		return false;
+	
+	_measureTransfers();
+	_cpuQueue.push(download.cpu);
+	_pboQueue.push(download.pbo);
+	_texQueue.push(download.tex);
+	_fboQueue.push(download.fbo);
+	_ringSlotQueue.push(make_pair(download.ring, download.slot));
+	_fenceQueue.push_back(download.fence);
+	_adaptiveDepth.noteSubmission();
+	return true;
+}
+GLBufferRef GLTexToCPUCopier::_popDownload()	{
+	if (_pboQueue.size() < 1)
+		return nullptr;
+	
+	PendingDownload		download;
+	download.cpu = _cpuQueue.front();
+	_cpuQueue.pop();
+	download.pbo = _pboQueue.front();
+	_pboQueue.pop();
+	download.tex = _texQueue.front();
+	_texQueue.pop();
+	download.fbo = _fboQueue.front();
+	_fboQueue.pop();
+	download.ring = _ringSlotQueue.front().first;
+	download.slot = _ringSlotQueue.front().second;
+	_ringSlotQueue.pop();
+	download.fence = _fenceQueue.front();
+	_fenceQueue.pop_front();
+	download.pool = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	
+	//	without a fence there's no way to tell when the transfer completed, so the download isn't timed
+	if (download.fence == nullptr)	{
+		_adaptiveDepth.noteDrop();
+		return _finishDownload(download);
+	}
+	
+	//	if the transfer hasn't completed yet, finishing the download will stall
+	bool			stalled = !FenceSignaled(download.fence);
+	GLBufferRef		returnMe = _finishDownload(download);
+	_adaptiveDepth.noteCompletion(0);
+	_adaptiveDepth.notePop(stalled);
+	_applyAdaptiveDepth();
+	return returnMe;
+}
+void GLTexToCPUCopier::_dropDownload()	{
+	if (_pboQueue.size() < 1)
+		return;
+	
+	_cpuQueue.pop();
+	_pboQueue.pop();
+	_texQueue.pop();
+	_fboQueue.pop();
+	if (_ringSlotQueue.front().first != nullptr)
+		_ringSlotQueue.front().first->releaseSlot(_ringSlotQueue.front().second);
+	_ringSlotQueue.pop();
+	
+	//	sync objects are shared, so the fence is deleted in whatever context is current (the setters make the queue context current first)
+	GLsync			tmpFence = _fenceQueue.front();
+	_fenceQueue.pop_front();
+	_adaptiveDepth.noteDrop();
+	if (tmpFence != nullptr)	{
+		glDeleteSync(tmpFence);
+		GLERRLOG
+	}
+}
+void GLTexToCPUCopier::_makeQueueCtxCurrentForDrops()	{
+	//	only the setters need this- the stream paths already have a context that shares the queue context current
+	if (_queueCtx != nullptr && _fenceQueue.size() > 0)
+		_queueCtx->makeCurrentIfNotCurrent();
+}
+void GLTexToCPUCopier::_clearQueues()	{
+	while (_pboQueue.size() > 0)
+		_dropDownload();
+	_adaptiveDepth.reset();
+}
+void GLTexToCPUCopier::_measureTransfers()	{
+	//	transfers complete in order, so we can stop at the first one that hasn't completed yet
+	int			index = 0;
+	for (const GLsync & fence : _fenceQueue)	{
+		if (!_adaptiveDepth.isComplete(index))	{
+			if (fence == nullptr || !FenceSignaled(fence))
+				break;
+			_adaptiveDepth.noteCompletion(index);
+		}
+		++index;
+	}
+}
+void GLTexToCPUCopier::_applyAdaptiveDepth()	{
+	if (!_adaptiveQueueSize || _queueSize == _adaptiveDepth.depth())
+		return;
+	_queueSize = _adaptiveDepth.depth();
+	//	the queues only shrink by dropping their oldest entries
+	while (static_cast<int>(_pboQueue.size()) > _queueSize)
+		_dropDownload();
+}
+
+
+/*	========================================	*/
+#pragma mark --------------------- public API
 
 
 GLBufferRef GLTexToCPUCopier::downloadTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
+	return downloadTexToCPU(inTexBuffer, Rect(), Size(), inCPUBuffer, createInCurrentContext);
+}
+GLBufferRef GLTexToCPUCopier::downloadTexToCPU(const GLBufferRef & inTexBuffer, const Rect & inRegion, const Size & inOutputSize, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
 	//cout << __PRETTY_FUNCTION__ << "... " << *inTexBuffer << endl;
 	//	bail if there's no texture to download
 	if (inTexBuffer == nullptr)
@@ -219,61 +976,37 @@ GLBufferRef GLTexToCPUCopier::downloadTexToCPU(const GLBufferRef & inTexBuffer,
 	
 	lock_guard<recursive_mutex>		lock(_queueLock);
 	
-	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
 	//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
 	if (!createInCurrentContext)
 		_queueCtx->makeCurrentIfNotCurrent();
 	
-	//Size			gpuBufferDims = inTexBuffer->srcRect.size;
-	
-	//	make an FBO
-	GLBufferRef			tmpFBO = CreateFBO(createInCurrentContext, bp);
-	//	create a PBO for the texture
-	GLBufferRef			inPBOBuffer = nullptr;
-	switch (inTexBuffer->desc.pixelFormat)	{
-	case GLBuffer::PF_RGBA:
-		inPBOBuffer = CreateRGBAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inTexBuffer->size, nullptr, createInCurrentContext, bp);
-		break;
-	case GLBuffer::PF_BGRA:
-		inPBOBuffer = CreateBGRAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inTexBuffer->size, nullptr, createInCurrentContext, bp);
-		break;
-	case GLBuffer::PF_YCbCr_422:
-		inPBOBuffer = CreateYCbCrPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, inTexBuffer->size, nullptr, createInCurrentContext, bp);
-		break;
-	default:
-		break;
-	}
-	
-	if (inPBOBuffer==nullptr)
+	//	start the download (converting the texture first if appropriate), then finish it immediately
+	PendingDownload		download;
+	if (!_startDownload(inTexBuffer, inCPUBuffer, createInCurrentContext, download, inRegion, inOutputSize))
 		return nullptr;
-	
-	_beginProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer, tmpFBO);
-	_finishProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer, tmpFBO);
-	
-	if (inCPUBuffer != nullptr)
-		return inCPUBuffer;
-	return inPBOBuffer;
+	return _finishDownload(download);
 }
 GLBufferRef GLTexToCPUCopier::streamTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
+	return streamTexToCPU(inTexBuffer, Rect(), Size(), inCPUBuffer, createInCurrentContext);
+}
+GLBufferRef GLTexToCPUCopier::streamTexToCPU(const GLBufferRef & inTexBuffer, const Rect & inRegion, const Size & inOutputSize, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
 	//cout << __PRETTY_FUNCTION__;
 	//if (inTexBuffer == nullptr) cout << endl;
 	//else cout << "... " << *inTexBuffer << endl;
 	
 	lock_guard<recursive_mutex>		lock(_queueLock);
 	
-	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
 	//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
 	if (!createInCurrentContext)
 		_queueCtx->makeCurrentIfNotCurrent();
 	
 	//	make sure the queues have the appropriate and expected number of elements
 	int			tmpQueueSize = static_cast<int>(_pboQueue.size());
-	if (tmpQueueSize != static_cast<int>(_cpuQueue.size()) || tmpQueueSize != static_cast<int>(_texQueue.size()))	{
+	if (tmpQueueSize != static_cast<int>(_cpuQueue.size()) || tmpQueueSize != static_cast<int>(_texQueue.size()) || tmpQueueSize != static_cast<int>(_fenceQueue.size()))	{
 		cout << "\tERR: queue size discrepancy, " << __PRETTY_FUNCTION__ << endl;
 		return nullptr;
 	}
 	
-	Size		texBufferDims = (inTexBuffer==nullptr) ? Size() : inTexBuffer->size;
 	bool		safeToPush = false;
 	bool		safeToPop = false;
 	//	we're safe to push if the queue isn't too large AND there's a non-null input buffer
@@ -283,60 +1016,116 @@ GLBufferRef GLTexToCPUCopier::streamTexToCPU(const GLBufferRef & inTexBuffer, co
 	if (tmpQueueSize>=_queueSize && safeToPush)
 		safeToPop = true;
 	
-	//	make an FBO- we need to attach the texture we want to download to this.
-	GLBufferRef		tmpFBO = nullptr;
-	//	if we're safe to push, we need to create a PBO
-	GLBufferRef		inPBOBuffer = nullptr;
-	if (safeToPush)	{
-		tmpFBO = CreateFBO(createInCurrentContext, bp);
-		switch (inTexBuffer->desc.pixelFormat)	{
-		case GLBuffer::PF_RGBA:
-			inPBOBuffer = CreateRGBAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, texBufferDims, nullptr, createInCurrentContext, bp);
-			break;
-		case GLBuffer::PF_BGRA:
-			inPBOBuffer = CreateBGRAPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, texBufferDims, nullptr, createInCurrentContext, bp);
-			break;
-		case GLBuffer::PF_YCbCr_422:
-			inPBOBuffer = CreateYCbCrPBO(GLBuffer::Target_PBOPack, GL_DYNAMIC_READ, texBufferDims, nullptr, createInCurrentContext, bp);
-			break;
-		default:
-			break;
+	//	push the buffer if appropriate- if we couldn't create the buffers we need then we're not safe to push, and if we're not safe to push then we're not safe to pop.
+	if (safeToPush && !_pushDownload(inTexBuffer, inCPUBuffer, createInCurrentContext, inRegion, inOutputSize))
+		safeToPop = false;
+	//	pop buffers off the queues if appropriate
+	if (safeToPop)
+		return _popDownload();
+	
+	return nullptr;
+}
+GLBufferRef GLTexToCPUCopier::tryStreamTexToCPU(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
+	lock_guard<recursive_mutex>		lock(_queueLock);
+	
+	//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
+	if (!createInCurrentContext)
+		_queueCtx->makeCurrentIfNotCurrent();
+	
+	//	make sure the queues have the appropriate and expected number of elements
+	int			tmpQueueSize = static_cast<int>(_pboQueue.size());
+	if (tmpQueueSize != static_cast<int>(_cpuQueue.size()) || tmpQueueSize != static_cast<int>(_texQueue.size()) || tmpQueueSize != static_cast<int>(_fenceQueue.size()))	{
+		cout << "\tERR: queue size discrepancy, " << __PRETTY_FUNCTION__ << endl;
+		return nullptr;
+	}
+	
+	if (inTexBuffer != nullptr)
+		_pushDownload(inTexBuffer, inCPUBuffer, createInCurrentContext);
+	
+	if (_pboQueue.size() < 1)
+		return nullptr;
+	
+	//	if there are more downloads in flight than the queue size allows, finish the oldest regardless of whether or not its transfer has completed
+	if (static_cast<int>(_pboQueue.size()) > _queueSize)
+		return _popDownload();
+	
+	GLsync			oldestFence = _fenceQueue.front();
+	//	if there's no fence the context doesn't support them- there's no way to check if the transfer has completed, so we have to wait for the queue to fill up (like streamTexToCPU())
+	if (oldestFence == nullptr)
+		return nullptr;
+	
+	//	check the oldest download's fence without waiting- only finish it if its transfer has completed
+	if (FenceSignaled(oldestFence))
+		return _popDownload();
+	
+	return nullptr;
+}
+GLBufferRef GLTexToCPUCopier::poll(const bool & createInCurrentContext)	{
+	return tryStreamTexToCPU(nullptr, nullptr, createInCurrentContext);
+}
+void GLTexToCPUCopier::downloadAsync(const GLBufferRef & inTexBuffer, const DownloadCallback & inCallback, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
+	if (inTexBuffer == nullptr)	{
+		if (inCallback != nullptr)
+			inCallback(nullptr);
+		return;
+	}
+	
+#if defined(VVGL_SDK_QT)
+	//	Qt contexts can only be used on the thread that owns them
+	GLBufferRef			result = downloadTexToCPU(inTexBuffer, inCPUBuffer, createInCurrentContext);
+	if (inCallback != nullptr)
+		inCallback(result);
+#else
+	AsyncDownloader::Job		job;
+	shared_ptr<AsyncDownloader>	worker = nullptr;
+	GLBufferRef			result = nullptr;
+	bool				started = false;
+	{
+		lock_guard<recursive_mutex>		lock(_queueLock);
+		
+		//	make the queue context current if appropriate- otherwise we are to assume that a GL context is current in this thread
+		if (!createInCurrentContext)
+			_queueCtx->makeCurrentIfNotCurrent();
+		
+		started = _startDownload(inTexBuffer, inCPUBuffer, createInCurrentContext, job.download);
+		
+		//	the worker's context can only wait for the transfer if there's a fence (GL doesn't order commands across contexts without one)- contexts without fences finish the download here, like the Qt path does
+		if (started && job.download.fence != nullptr)	{
+			if (_asyncDownloader == nullptr && _queueCtx != nullptr)	{
+				GLContextRef		workerCtx = _queueCtx->newContextSharingMe();
+				if (workerCtx != nullptr)	{
+					if (!createInCurrentContext)
+						_queueCtx->makeCurrentIfNotCurrent();
+					_asyncDownloader = make_shared<AsyncDownloader>(workerCtx, this);
+					_asyncDownloader->start();
+				}
+			}
+			worker = _asyncDownloader;
 		}
 		
-		//	if we couldn't create the buffers we need then we're not safe to push, and if we're not safe to push then we're not safe to pop.
-		if (inPBOBuffer==nullptr)	{
-			cout << "\tERR: couldnt make PBO, " << __PRETTY_FUNCTION__ << endl;
-			safeToPush = false;
-			safeToPop = false;
+		if (started && worker == nullptr)	{
+			result = _finishDownload(job.download);
+			job.download = PendingDownload();
 		}
 	}
 	
-	//	push the buffer if appropriate
-	if (safeToPush)	{
-		_cpuQueue.push(inCPUBuffer);
-		_pboQueue.push(inPBOBuffer);
-		_texQueue.push(inTexBuffer);
-		_fboQueue.push(tmpFBO);
-		_beginProcessing(inCPUBuffer, inPBOBuffer, inTexBuffer, tmpFBO);
-	}
-	//	pop buffers off the queues if appropriate
-	if (safeToPop)	{
-		GLBufferRef		outCPUBuffer = _cpuQueue.front();
-		_cpuQueue.pop();
-		GLBufferRef		outPBOBuffer = _pboQueue.front();
-		_pboQueue.pop();
-		GLBufferRef		outTexBuffer = _texQueue.front();
-		_texQueue.pop();
-		GLBufferRef		outFBO = _fboQueue.front();
-		_fboQueue.pop();
-		_finishProcessing(outCPUBuffer, outPBOBuffer, outTexBuffer, outFBO);
-		if (outCPUBuffer != nullptr)
-			return outCPUBuffer;
-		else
-			return outPBOBuffer;
+	if (worker == nullptr)	{
+		if (inCallback != nullptr)
+			inCallback(result);
+		return;
 	}
 	
-	return nullptr;
+	job.callback = inCallback;
+	worker->addJob(move(job));
+#endif
+}
+future<GLBufferRef> GLTexToCPUCopier::downloadAsync(const GLBufferRef & inTexBuffer, const GLBufferRef & inCPUBuffer, const bool & createInCurrentContext)	{
+	shared_ptr<promise<GLBufferRef>>		tmpPromise = make_shared<promise<GLBufferRef>>();
+	future<GLBufferRef>		returnMe = tmpPromise->get_future();
+	downloadAsync(inTexBuffer, [tmpPromise](const GLBufferRef & n)	{
+		tmpPromise->set_value(n);
+	}, inCPUBuffer, createInCurrentContext);
+	return returnMe;
 }
 
 
@@ -346,6 +1135,6 @@ GLBufferRef GLTexToCPUCopier::streamTexToCPU(const GLBufferRef & inTexBuffer, co
 
 
 
-#endif	//	!defined(VVGL_TARGETENV_GLES) && !defined(VVGL_TARGETENV_GLES3)
+#endif	//	!defined(VVGL_TARGETENV_GLES)
 
 
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <iostream>
+#include <cmath>
 
 #include "GLContext.hpp"
 
@@ -31,6 +32,9 @@ GLTexToTexCopier::GLTexToTexCopier(const GLContextRef & inCtx) : GLScene(inCtx)
 
 void GLTexToTexCopier::prepareToBeDeleted()	{
 	//cout << __PRETTY_FUNCTION__ << "->" << this << endl;
+	//	free the filter copiers (they use our context) first
+	for (GLTexToTexCopierRef & copier : _filterCopiers)
+		copier = nullptr;
 	//	now call the super, which deletes the context
 	GLScene::prepareToBeDeleted();
 }
@@ -42,6 +46,7 @@ GLTexToTexCopier::~GLTexToTexCopier()	{
 	
 #if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
 	_vao = nullptr;
+	_batchVAO = nullptr;
 #elif defined(VVGL_TARGETENV_GLES)
 	_vbo = nullptr;
 #endif
@@ -141,6 +146,7 @@ void main()	{\r\n\
 		setVertexShaderString(vsString);
 		setFragmentShaderString(fsString);
 	}
+	_defaultShaders = true;
 	
 	setRenderPrepCallback([&](const GLScene & /*n*/, const bool /*inReshaped*/, const bool & inPgmChanged) {
 		if (inPgmChanged)	{
@@ -162,6 +168,16 @@ void main()	{\r\n\
 void GLTexToTexCopier::_initialize()	{
 	GLScene::_initialize();
 }
+void GLTexToTexCopier::setVertexShaderString(const string & n)	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	GLScene::setVertexShaderString(n);
+	_defaultShaders = false;
+}
+void GLTexToTexCopier::setFragmentShaderString(const string & n)	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	GLScene::setFragmentShaderString(n);
+	_defaultShaders = false;
+}
 
 
 /*	========================================	*/
@@ -200,6 +216,22 @@ SizingMode GLTexToTexCopier::copySizingMode()	{
 	lock_guard<recursive_mutex>		lock(_renderLock);
 	return _copySizingMode;
 }
+void GLTexToTexCopier::setFastCopy(const bool & n)	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	_fastCopy = n;
+}
+bool GLTexToTexCopier::fastCopy()	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	return _fastCopy;
+}
+void GLTexToTexCopier::setDownscaleFilter(const DownscaleFilter & n)	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	_downscaleFilter = n;
+}
+GLTexToTexCopier::DownscaleFilter GLTexToTexCopier::downscaleFilter()	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	return _downscaleFilter;
+}
 
 
 /*	========================================	*/
@@ -233,6 +265,12 @@ GLBufferRef GLTexToTexCopier::copyToNewBuffer(const GLBufferRef & n)	{
 	}
 	_context->makeCurrentIfNotCurrent();
 	
+	//	if we're shrinking the buffer and a downscale filter has been selected, use it
+	if (_copyAndResize && _filteredCopy(n, color, Rect(0,0,_orthoSize.width,_orthoSize.height)))	{
+		_renderTarget = RenderTarget();
+		return color;
+	}
+	
 	//	prep for render
 	_renderPrep();
 	
@@ -279,6 +317,12 @@ bool GLTexToTexCopier::copyFromTo(const GLBufferRef & a, const GLBufferRef & b)
 	//_context->makeCurrent();
 	//_context->makeCurrentIfNull();
 	
+	//	if we can copy the texture without drawing it, do so
+	if (_fastCopyFromTo(a, b, Rect(0,0,a->srcRect.size.width,a->srcRect.size.height)))	{
+		_renderTarget = RenderTarget();
+		return true;
+	}
+	
 	//	prep for render
 	_renderPrep();
 	
@@ -322,12 +366,18 @@ void GLTexToTexCopier::sizeVariantCopy(const GLBufferRef & a, const GLBufferRef
 	//_context->makeCurrent();
 	//_context->makeCurrentIfNull();
 	
+	//	if we're shrinking the texture and a downscale filter has been selected, use it- otherwise, if we can copy the texture without drawing it, do so
+	Rect					geometryRect = ResizeRect(a->srcRect, Rect(0,0,_orthoSize.width,_orthoSize.height), _copySizingMode);
+	if (_filteredCopy(a, b, geometryRect) || _fastCopyFromTo(a, b, geometryRect))	{
+		_renderTarget = RenderTarget();
+		return;
+	}
+	
 	//	prep for render
 	_renderPrep();
 	
 	//	assemble a quad object that describes what we're going to draw
 	Quad<VertXYZST>			targetQuad;
-	Rect					geometryRect = ResizeRect(a->srcRect, Rect(0,0,_orthoSize.width,_orthoSize.height), _copySizingMode);
 	targetQuad.populateGeo(geometryRect);
 	targetQuad.populateTex(a->glReadySrcRect(), a->flipped);
 	
@@ -363,6 +413,12 @@ void GLTexToTexCopier::ignoreSizeCopy(const GLBufferRef & a, const GLBufferRef &
 	//_context->makeCurrent();
 	//_context->makeCurrentIfNull();
 	
+	//	if we can copy the texture without drawing it, do so
+	if (_fastCopyFromTo(a, b, Rect(0,0,a->srcRect.size.width,a->srcRect.size.height)))	{
+		_renderTarget = RenderTarget();
+		return;
+	}
+	
 	//	prep for render
 	_renderPrep();
 	
@@ -383,6 +439,53 @@ void GLTexToTexCopier::ignoreSizeCopy(const GLBufferRef & a, const GLBufferRef &
 }
 
 
+void GLTexToTexCopier::copyBatch(const vector<BatchCopy> & inCopies, const GLBufferRef & inDst)	{
+	
+	if (inDst == nullptr)
+		return;
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	setOrthoSize(inDst->size);
+	
+	//	create a render target using the buffers i'm rendering into
+	_renderTarget = RenderTarget(CreateFBO(false, bp), inDst, nullptr);
+	
+	//	lock, then prep for render (this creates the ctx).
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	if (_context == nullptr)	{
+		cout << "\terr: bailing, ctx null, " << __PRETTY_FUNCTION__ << endl;
+		return;
+	}
+	_context->makeCurrentIfNotCurrent();
+	
+	//	prep for render- the target is bound and cleared once for the whole batch
+	_renderPrep();
+	
+	GLVersion			myVers = glVersion();
+	if (myVers==GLVersion_ES3 || myVers==GLVersion_33 || myVers==GLVersion_4)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+		_drawBatch(inCopies);
+#endif
+	}
+	else	{
+		//	older versions of GL draw each copy separately
+		for (const BatchCopy & copy : inCopies)	{
+			if (copy.first == nullptr)
+				continue;
+			Quad<VertXYZST>			targetQuad;
+			targetQuad.populateGeo(copy.second);
+			targetQuad.populateTex(copy.first->glReadySrcRect(), copy.first->flipped);
+			_drawBuffer(copy.first, targetQuad);
+		}
+	}
+	
+	//	cleanup after render
+	_renderCleanup();
+	
+	//	clear out the render target
+	_renderTarget = RenderTarget();
+	
+}
 void GLTexToTexCopier::copyBlackFrameTo(const GLBufferRef & n)	{
 	
 	if (n == nullptr)
@@ -427,6 +530,101 @@ void GLTexToTexCopier::copyRedFrameTo(const GLBufferRef & n)	{
 	renderRedFrame(newTarget);
 	
 }
+void GLTexToTexCopier::clearBuffers(const vector<GLBufferRef> & inBuffers, const GLColor & inColor)	{
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	if (_context == nullptr)	{
+		cout << "\terr: bailing, ctx null, " << __PRETTY_FUNCTION__ << endl;
+		return;
+	}
+	_context->makeCurrentIfNotCurrent();
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	GLBufferRef			fbo = CreateFBO(false, bp);
+	
+	//	sort the buffers into the ones we can clear directly and the ones that need a render pass
+	vector<GLBufferRef>		directClears;
+	vector<GLBufferRef>		drawnClears;
+	directClears.reserve(inBuffers.size());
+	for (const auto & buffer : inBuffers)	{
+		if (buffer == nullptr)
+			continue;
+		if (fbo!=nullptr && _canClearWithoutDraw(buffer))
+			directClears.push_back(buffer);
+		else
+			drawnClears.push_back(buffer);
+	}
+	
+	if (directClears.size() > 0)
+		_clearTextures(directClears, inColor, fbo);
+	
+	for (const auto & buffer : drawnClears)	{
+		setOrthoSize(buffer->size);
+		_renderTarget = RenderTarget(fbo, buffer, nullptr);
+		_renderPrep();
+		
+		glClearColor(inColor.r, inColor.g, inColor.b, inColor.a);
+		GLERRLOG
+		glClear(GL_COLOR_BUFFER_BIT);
+		GLERRLOG
+		_clearColorUpdated = true;
+		
+		_renderCleanup();
+		_renderTarget = RenderTarget();
+	}
+}
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+void GLTexToTexCopier::_bindInputBuffer(const GLBufferRef & inBufferRef)	{
+	//	pass the 2D texture to the program (if there is a 2D texture)
+	glActiveTexture(GL_TEXTURE0);
+	GLERRLOG
+	glBindTexture(GL_TEXTURE_2D, (inBufferRef!=nullptr && inBufferRef->desc.target==GLBuffer::Target_2D) ? inBufferRef->name : 0);
+	GLERRLOG
+	//glBindTexture(GLBuffer::Target_2D, 0);
+	//GLERRLOG
+	if (_inputImageLoc.loc >= 0)	{
+		glUniform1i(_inputImageLoc.loc, 0);
+		GLERRLOG
+	}
+#if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_WIN)
+	//	pass the RECT texture to the program (if there is a RECT texture)
+	glActiveTexture(GL_TEXTURE1);
+	GLERRLOG
+	//glBindTexture(GL_TEXTURE_2D, 0);
+	//GLERRLOG
+	glBindTexture(GLBuffer::Target_Rect, (inBufferRef!=nullptr && inBufferRef->desc.target==GLBuffer::Target_Rect) ? inBufferRef->name : 0);
+	GLERRLOG
+	if (_inputImageRectLoc.loc >= 0)	{
+		glUniform1i(_inputImageRectLoc.loc, 1);
+		GLERRLOG
+	}
+#endif	//	VVGL_SDK_MAC || VVGL_SDK_WIN
+	//	pass an int to the program that indicates whether we're passing a 2D or a RECT texture
+	if (_isRectTexLoc.loc >= 0)	{
+		if (inBufferRef == nullptr)	{
+			glUniform1i(_isRectTexLoc.loc, 0);
+			GLERRLOG
+		}
+		else	{
+			switch (inBufferRef->desc.target)	{
+			case GLBuffer::Target_2D:
+				glUniform1i(_isRectTexLoc.loc, 1);
+				GLERRLOG
+				break;
+#if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_WIN)
+			case GLBuffer::Target_Rect:
+				glUniform1i(_isRectTexLoc.loc, 2);
+				GLERRLOG
+				break;
+#endif	//	VVGL_SDK_MAC || VVGL_SDK_WIN
+			default:
+				glUniform1i(_isRectTexLoc.loc, 0);
+				GLERRLOG
+				break;
+			}
+		}
+	}
+}
+#endif
 void GLTexToTexCopier::_drawBuffer(const GLBufferRef & inBufferRef, const Quad<VertXYZST> & inVertexStruct)	{
 	GLVersion			myVers = glVersion();
 	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
@@ -480,55 +678,8 @@ void GLTexToTexCopier::_drawBuffer(const GLBufferRef & inBufferRef, const Quad<V
 			glBindVertexArray(_vao->name);
 			GLERRLOG
 		}
-		//	pass the 2D texture to the program (if there is a 2D texture)
-		glActiveTexture(GL_TEXTURE0);
-		GLERRLOG
-		glBindTexture(GL_TEXTURE_2D, (inBufferRef!=nullptr && inBufferRef->desc.target==GLBuffer::Target_2D) ? inBufferRef->name : 0);
-		GLERRLOG
-		//glBindTexture(GLBuffer::Target_2D, 0);
-		//GLERRLOG
-		if (_inputImageLoc.loc >= 0)	{
-			glUniform1i(_inputImageLoc.loc, 0);
-			GLERRLOG
-		}
-#if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_WIN)
-		//	pass the RECT texture to the program (if there is a RECT texture)
-		glActiveTexture(GL_TEXTURE1);
-		GLERRLOG
-		//glBindTexture(GL_TEXTURE_2D, 0);
-		//GLERRLOG
-		glBindTexture(GLBuffer::Target_Rect, (inBufferRef!=nullptr && inBufferRef->desc.target==GLBuffer::Target_Rect) ? inBufferRef->name : 0);
-		GLERRLOG
-		if (_inputImageRectLoc.loc >= 0)	{
-			glUniform1i(_inputImageRectLoc.loc, 1);
-			GLERRLOG
-		}
-#endif	//	VVGL_SDK_MAC || VVGL_SDK_WIN
-		//	pass an int to the program that indicates whether we're passing a 2D or a RECT texture
-		if (_isRectTexLoc.loc >= 0)	{
-			if (inBufferRef == nullptr)	{
-				glUniform1i(_isRectTexLoc.loc, 0);
-				GLERRLOG
-			}
-			else	{
-				switch (inBufferRef->desc.target)	{
-				case GLBuffer::Target_2D:
-					glUniform1i(_isRectTexLoc.loc, 1);
-					GLERRLOG
-					break;
-#if defined(VVGL_SDK_MAC) || defined(VVGL_SDK_WIN)
-				case GLBuffer::Target_Rect:
-					glUniform1i(_isRectTexLoc.loc, 2);
-					GLERRLOG
-					break;
-#endif	//	VVGL_SDK_MAC || VVGL_SDK_WIN
-				default:
-					glUniform1i(_isRectTexLoc.loc, 0);
-					GLERRLOG
-					break;
-				}
-			}
-		}
+		//	pass the texture to the program
+		_bindInputBuffer(inBufferRef);
 	
 		//	draw!
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
@@ -671,6 +822,495 @@ void GLTexToTexCopier::_drawBuffer(const GLBufferRef & inBufferRef, const Quad<V
 	}
 }
 
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+void GLTexToTexCopier::_drawBatch(const vector<BatchCopy> & inCopies)	{
+	//	assemble two triangles per copy in a single vertex array
+	vector<VertXYZST>		verts;
+	verts.reserve(inCopies.size() * 6);
+	for (const BatchCopy & copy : inCopies)	{
+		if (copy.first == nullptr)
+			continue;
+		Quad<VertXYZST>			targetQuad;
+		targetQuad.populateGeo(copy.second);
+		targetQuad.populateTex(copy.first->glReadySrcRect(), copy.first->flipped);
+		verts.push_back(targetQuad.bl);
+		verts.push_back(targetQuad.br);
+		verts.push_back(targetQuad.tl);
+		verts.push_back(targetQuad.tl);
+		verts.push_back(targetQuad.br);
+		verts.push_back(targetQuad.tr);
+	}
+	if (verts.size() < 1)
+		return;
+	
+	//	make the VAO if we don't already have one
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	if (_batchVAO == nullptr)
+		_batchVAO = CreateVAO(true, bp);
+	if (_batchVAO == nullptr)
+		return;
+	
+	//	bind the VAO, make a VBO and populate it with the vertex data for the whole batch
+	glBindVertexArray(_batchVAO->name);
+	GLERRLOG
+	uint32_t		tmpVBO = 0;
+	glGenBuffers(1, &tmpVBO);
+	GLERRLOG
+	glBindBuffer(GL_ARRAY_BUFFER, tmpVBO);
+	GLERRLOG
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(verts.size() * sizeof(VertXYZST)), verts.data(), GL_STREAM_DRAW);
+	GLERRLOG
+	//	configure the attribute pointers to work with the VBO
+	if (_inputXYZLoc.loc >= 0)	{
+		_inputXYZLoc.enable();
+		glVertexAttribPointer(_inputXYZLoc.loc, 3, GL_FLOAT, GL_FALSE, sizeof(VertXYZST), BUFFER_OFFSET(verts[0].geoOffset()));
+		GLERRLOG
+	}
+	if (_inputSTLoc.loc >= 0)	{
+		_inputSTLoc.enable();
+		glVertexAttribPointer(_inputSTLoc.loc, 2, GL_FLOAT, GL_FALSE, sizeof(VertXYZST), BUFFER_OFFSET(verts[0].texOffset()));
+		GLERRLOG
+	}
+	
+	//	draw the copies- consecutive copies of the same texture are drawn with a single draw call
+	GLBufferRef		runBuffer = nullptr;
+	GLint			runStart = 0;
+	GLint			vertIndex = 0;
+	for (const BatchCopy & copy : inCopies)	{
+		if (copy.first == nullptr)
+			continue;
+		if (runBuffer==nullptr || runBuffer->name!=copy.first->name || runBuffer->desc.target!=copy.first->desc.target)	{
+			if (runBuffer != nullptr)	{
+				glDrawArrays(GL_TRIANGLES, runStart, vertIndex - runStart);
+				GLERRLOG
+			}
+			_bindInputBuffer(copy.first);
+			runBuffer = copy.first;
+			runStart = vertIndex;
+		}
+		vertIndex += 6;
+	}
+	if (runBuffer != nullptr)	{
+		glDrawArrays(GL_TRIANGLES, runStart, vertIndex - runStart);
+		GLERRLOG
+	}
+	
+	//	unbind the VAO and delete the VBO- the draws have been queued, so GL keeps its contents around until they have been performed
+	glBindVertexArray(0);
+	GLERRLOG
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLERRLOG
+	glDeleteBuffers(1, &tmpVBO);
+	GLERRLOG
+}
+#endif
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- fast copy
+
+
+bool GLTexToTexCopier::_fastCopyFromTo(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	//	the fast paths don't run the program, so they're only equivalent to a draw with our own shaders
+	if (!_fastCopy || !_defaultShaders || a==nullptr || b==nullptr)
+		return false;
+	if (a->desc.type!=GLBuffer::Type_Tex || b->desc.type!=GLBuffer::Type_Tex || a->name==0 || b->name==0 || a->name==b->name)
+		return false;
+	GLVersion			myVers = glVersion();
+	if (myVers!=GLVersion_33 && myVers!=GLVersion_4 && myVers!=GLVersion_ES3)
+		return false;
+	
+	//	neither path can draw fractional pixels, and both have to stay within the textures
+	const Rect			&srcRect = a->srcRect;
+	auto				isIntegral = [](const Rect & r)	{
+		return (r.origin.x==floor(r.origin.x) && r.origin.y==floor(r.origin.y) && r.size.width==floor(r.size.width) && r.size.height==floor(r.size.height) && r.size.width>=1. && r.size.height>=1.);
+	};
+	if (!isIntegral(srcRect) || !isIntegral(inDstRect))
+		return false;
+	if (srcRect.minX()<0. || srcRect.minY()<0. || srcRect.maxX()>a->size.width || srcRect.maxY()>a->size.height)
+		return false;
+	if (inDstRect.minX()<0. || inDstRect.minY()<0. || inDstRect.maxX()>b->size.width || inDstRect.maxY()>b->size.height)
+		return false;
+	//	neither path clears the destination- that's only OK if the copy covers all of it
+	if (_performClear && inDstRect!=Rect(0,0,b->size.width,b->size.height))
+		return false;
+	
+	GLint			srcX = static_cast<GLint>(srcRect.origin.x);
+	GLint			srcY = static_cast<GLint>(srcRect.origin.y);
+	GLint			srcW = static_cast<GLint>(srcRect.size.width);
+	GLint			srcH = static_cast<GLint>(srcRect.size.height);
+	GLint			dstX = static_cast<GLint>(inDstRect.origin.x);
+	GLint			dstY = static_cast<GLint>(inDstRect.origin.y);
+	GLint			dstW = static_cast<GLint>(inDstRect.size.width);
+	GLint			dstH = static_cast<GLint>(inDstRect.size.height);
+	bool			sameSize = (srcW==dstW && srcH==dstH);
+	
+	//	the cheapest copy is a raw texel copy, which doesn't need an FBO at all- it can't flip, scale, or convert between formats
+#if defined(VVGL_SDK_GLFW) || defined(VVGL_SDK_QT) || defined(VVGL_SDK_WIN)
+	if (sameSize && !a->flipped && a->desc.internalFormat==b->desc.internalFormat && (GLEW_VERSION_4_3 || GLEW_ARB_copy_image))	{
+		glCopyImageSubData(a->name, a->desc.target, 0, srcX, srcY, 0, b->name, b->desc.target, 0, dstX, dstY, 0, srcW, srcH, 1);
+		GLERRLOG
+		glFlush();
+		GLERRLOG
+		return true;
+	}
+#endif
+	
+	//	the next-cheapest is a blit, which can flip and scale- we only use it for integer scale factors (to match the quad's sampling), between color-renderable textures with the same kind of components
+	if (_renderTarget.fboName() == 0)
+		return false;
+	auto			isColorRenderable = [](const GLBufferRef & n)	{
+		return (n->desc.pixelFormat==GLBuffer::PF_RGBA || n->desc.pixelFormat==GLBuffer::PF_BGRA);
+	};
+	auto			isFloat = [](const GLBufferRef & n)	{
+		return (n->desc.pixelType==GLBuffer::PT_Float || n->desc.pixelType==GLBuffer::PT_HalfFloat);
+	};
+	if (!isColorRenderable(a) || !isColorRenderable(b) || isFloat(a)!=isFloat(b))
+		return false;
+	bool			integerScale = ((dstW%srcW==0 || srcW%dstW==0) && (dstH%srcH==0 || srcH%dstH==0));
+	if (!integerScale)
+		return false;
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	GLBufferRef			readFBO = CreateFBO(false, bp);
+	if (readFBO == nullptr)
+		return false;
+	
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO->name);
+	GLERRLOG
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, a->desc.target, a->name, 0);
+	GLERRLOG
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _renderTarget.fboName());
+	GLERRLOG
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, b->desc.target, b->name, 0);
+	GLERRLOG
+	
+	//	a flipped source is un-flipped by swapping the destination's top and bottom
+	GLint			dstY0 = (a->flipped) ? dstY+dstH : dstY;
+	GLint			dstY1 = (a->flipped) ? dstY : dstY+dstH;
+	glBlitFramebuffer(srcX, srcY, srcX+srcW, srcY+srcH, dstX, dstY0, dstX+dstW, dstY1, GL_COLOR_BUFFER_BIT, (sameSize) ? GL_NEAREST : GL_LINEAR);
+	GLERRLOG
+	
+	//	detach the textures and unbind the framebuffers
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, b->desc.target, 0, 0);
+	GLERRLOG
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, a->desc.target, 0, 0);
+	GLERRLOG
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLERRLOG
+	glFlush();
+	GLERRLOG
+	return true;
+#else
+	//	ES 2 and legacy GL have neither glBlitFramebuffer() nor glCopyImageSubData()
+	(void)a;
+	(void)b;
+	(void)inDstRect;
+	return false;
+#endif
+}
+
+
+
+
+/*	========================================	*/
+#pragma mark --------------------- downscale filters
+
+
+//	the indices of the copiers in '_filterCopiers'
+enum FilterIndex	{
+	FilterIndex_Box = 0,
+	FilterIndex_BicubicH,
+	FilterIndex_BicubicV,
+	FilterIndex_LanczosH,
+	FilterIndex_LanczosV
+};
+
+
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+//	everything the filter programs have in common.  sampleAt() samples the source at a location in pixels, and centerPx() returns the location (in the source's pixels) that this fragment maps to.
+static const string		FilterFragHeader(
+#if defined(VVGL_TARGETENV_GLES3)
+"\r\n\
+#version 300 es\r\n\
+precision highp		float;\r\n\
+in vec2		programST;\r\n\
+uniform sampler2D		inputImage;\r\n\
+uniform int		isRectTex;\r\n\
+out vec4		FragColor;\r\n\
+vec4 sampleAt(vec2 px)	{\r\n\
+	return texture(inputImage, px/vec2(textureSize(inputImage,0)));\r\n\
+}\r\n\
+vec2 centerPx()	{\r\n\
+	return programST * vec2(textureSize(inputImage,0));\r\n\
+}\r\n\
+"
+#else
+"\r\n\
+#version 330 core\r\n\
+in vec2		programST;\r\n\
+uniform sampler2D		inputImage;\r\n\
+uniform sampler2DRect	inputImageRect;\r\n\
+uniform int		isRectTex;\r\n\
+out vec4		FragColor;\r\n\
+vec4 sampleAt(vec2 px)	{\r\n\
+	if (isRectTex==1)\r\n\
+		return texture(inputImage, px/vec2(textureSize(inputImage,0)));\r\n\
+	else if (isRectTex==2)\r\n\
+		return texture(inputImageRect, px);\r\n\
+	return vec4(0,0,0,1);\r\n\
+}\r\n\
+vec2 centerPx()	{\r\n\
+	return (isRectTex==1) ? programST * vec2(textureSize(inputImage,0)) : programST;\r\n\
+}\r\n\
+"
+#endif
+);
+//	averages the source pixels covered by this fragment with up to 8x8 bilinear taps, each of which averages (up to) 2x2 pixels
+static const string		FilterFragBox("\r\n\
+void main()	{\r\n\
+	vec2		center = centerPx();\r\n\
+	vec2		footprint = max(abs(vec2(dFdx(center).x, dFdy(center).y)), vec2(1.0));\r\n\
+	ivec2		taps = clamp(ivec2(ceil(footprint*0.5)), ivec2(1), ivec2(8));\r\n\
+	vec2		tapStep = footprint / vec2(taps);\r\n\
+	vec2		firstTap = center - footprint*0.5 + tapStep*0.5;\r\n\
+	vec4		sum = vec4(0.0);\r\n\
+	for (int y=0; y<taps.y; ++y)	{\r\n\
+		for (int x=0; x<taps.x; ++x)\r\n\
+			sum += sampleAt(firstTap + tapStep*vec2(float(x),float(y)));\r\n\
+	}\r\n\
+	FragColor = sum / float(taps.x*taps.y);\r\n\
+}\r\n\
+");
+//	catmull-rom
+static const string		FilterFragBicubicKernel("\r\n\
+const float		kernelSupport = 2.0;\r\n\
+float kernelAt(float x)	{\r\n\
+	x = abs(x);\r\n\
+	if (x < 1.0)\r\n\
+		return ((1.5*x - 2.5)*x)*x + 1.0;\r\n\
+	if (x < 2.0)\r\n\
+		return ((-0.5*x + 2.5)*x - 4.0)*x + 2.0;\r\n\
+	return 0.0;\r\n\
+}\r\n\
+");
+//	3-lobe lanczos
+static const string		FilterFragLanczosKernel("\r\n\
+const float		kernelSupport = 3.0;\r\n\
+float kernelAt(float x)	{\r\n\
+	x = abs(x);\r\n\
+	if (x < 0.00001)\r\n\
+		return 1.0;\r\n\
+	if (x >= 3.0)\r\n\
+		return 0.0;\r\n\
+	float		px = 3.14159265 * x;\r\n\
+	return 3.0 * sin(px) * sin(px/3.0) / (px*px);\r\n\
+}\r\n\
+");
+static const string		FilterFragHorizontal("\r\n\
+const vec2		filterDir = vec2(1.0, 0.0);\r\n\
+");
+static const string		FilterFragVertical("\r\n\
+const vec2		filterDir = vec2(0.0, 1.0);\r\n\
+");
+//	convolves the source pixels along 'filterDir' with the kernel, widened by the scale factor so it also antialiases
+static const string		FilterFragSeparable("\r\n\
+void main()	{\r\n\
+	vec2		center = centerPx();\r\n\
+	float		scale = max(abs(dot(vec2(dFdx(center).x, dFdy(center).y), filterDir)), 1.0);\r\n\
+	float		radius = kernelSupport * scale;\r\n\
+	float		c = dot(center, filterDir);\r\n\
+	float		firstTexel = floor(c - radius + 0.5) + 0.5;\r\n\
+	int			taps = int(ceil(2.0*radius)) + 1;\r\n\
+	vec4		sum = vec4(0.0);\r\n\
+	float		weightSum = 0.0;\r\n\
+	for (int i=0; i<taps; ++i)	{\r\n\
+		float		t = firstTexel + float(i);\r\n\
+		float		w = kernelAt((t - c) / scale);\r\n\
+		sum += w * sampleAt(center + filterDir*(t - c));\r\n\
+		weightSum += w;\r\n\
+	}\r\n\
+	FragColor = (weightSum != 0.0) ? sum/weightSum : sampleAt(center);\r\n\
+}\r\n\
+");
+#endif	//	VVGL_TARGETENV_GL3PLUS || VVGL_TARGETENV_GLES3
+
+
+void GLTexToTexCopier::_drawInto(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect, const bool & inFastCopy)	{
+	if (a==nullptr || b==nullptr)
+		return;
+	
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	
+	lock_guard<recursive_mutex>		lock(_renderLock);
+	setOrthoSize(b->srcRect.size);
+	
+	//	create a render target using the buffers i'm rendering into
+	_renderTarget = RenderTarget(CreateFBO(false, bp), b, nullptr);
+	
+	if (_context == nullptr)	{
+		cout << "\terr: bailing, ctx null, " << __PRETTY_FUNCTION__ << endl;
+		_renderTarget = RenderTarget();
+		return;
+	}
+	_context->makeCurrentIfNotCurrent();
+	
+	if (!inFastCopy || !_fastCopyFromTo(a, b, inDstRect))	{
+		//	prep for render
+		_renderPrep();
+		
+		//	assemble a quad object that describes what we're going to draw, then draw the texture in it
+		Quad<VertXYZST>			targetQuad;
+		targetQuad.populateGeo(inDstRect);
+		targetQuad.populateTex(a->glReadySrcRect(), a->flipped);
+		_drawBuffer(a, targetQuad);
+		
+		//	cleanup after render
+		_renderCleanup();
+	}
+	
+	//	clear out the render target
+	_renderTarget = RenderTarget();
+}
+bool GLTexToTexCopier::_filteredCopy(const GLBufferRef & a, const GLBufferRef & b, const Rect & inDstRect)	{
+#if defined(VVGL_TARGETENV_GL3PLUS) || defined(VVGL_TARGETENV_GLES3)
+	if (_downscaleFilter==DownscaleFilter_Bilinear || a==nullptr || b==nullptr)
+		return false;
+	if (a->desc.type!=GLBuffer::Type_Tex || b->desc.type!=GLBuffer::Type_Tex)
+		return false;
+	GLVersion			myVers = glVersion();
+	if (myVers!=GLVersion_33 && myVers!=GLVersion_4 && myVers!=GLVersion_ES3)
+		return false;
+	
+	//	figure out how much we're shrinking the source by- a single bilinear draw is fine up to 2x, but the separable filters are sharper even when they aren't shrinking much
+	Size				dstSize(max(1., round(inDstRect.size.width)), max(1., round(inDstRect.size.height)));
+	double				ratio = max(a->srcRect.size.width/dstSize.width, a->srcRect.size.height/dstSize.height);
+	bool				separable = (_downscaleFilter==DownscaleFilter_Bicubic || _downscaleFilter==DownscaleFilter_Lanczos);
+	if (ratio <= ((separable) ? 1. : 2.))
+		return false;
+	
+	//	intermediates come from the pool, and are float if the source is
+	GLBufferPoolRef		bp = (_privatePool!=nullptr) ? _privatePool : GetGlobalBufferPool();
+	bool				isFloat = (a->desc.pixelType==GLBuffer::PT_Float || a->desc.pixelType==GLBuffer::PT_HalfFloat);
+	auto				createIntermediate = [&](const Size & inSize)	{
+		return (isFloat) ? CreateRGBAFloatTex(inSize, false, bp) : CreateRGBATex(inSize, false, bp);
+	};
+	//	returns the filter copier at the passed index, creating it if necessary.  filter copiers never take the fast path (a blit would skip the filter).
+	auto				filterCopierAt = [&](const int & inIndex)	{
+		GLTexToTexCopierRef		&copier = _filterCopiers[inIndex];
+		if (copier == nullptr)	{
+			string			fragString = FilterFragHeader;
+			switch (inIndex)	{
+			case FilterIndex_Box:		fragString += FilterFragBox; break;
+			case FilterIndex_BicubicH:	fragString += FilterFragBicubicKernel + FilterFragHorizontal + FilterFragSeparable; break;
+			case FilterIndex_BicubicV:	fragString += FilterFragBicubicKernel + FilterFragVertical + FilterFragSeparable; break;
+			case FilterIndex_LanczosH:	fragString += FilterFragLanczosKernel + FilterFragHorizontal + FilterFragSeparable; break;
+			case FilterIndex_LanczosV:	fragString += FilterFragLanczosKernel + FilterFragVertical + FilterFragSeparable; break;
+			}
+			copier = CreateGLTexToTexCopierRefUsing(_context);
+			copier->setPrivatePool(_privatePool);
+			copier->setFragmentShaderString(fragString);
+			copier->_fastCopy = false;
+		}
+		return copier;
+	};
+	//	the pass that draws into the destination clears it the way we would have
+	auto				finalCopier = [&](const int & inIndex)	{
+		GLTexToTexCopierRef		copier = filterCopierAt(inIndex);
+		copier->setPerformClear(_performClear);
+		copier->setClearColor(_clearColor);
+		return copier;
+	};
+	
+	GLBufferRef			current = a;
+	Size				currentSize = a->srcRect.size;
+	//	box-filters 'current' toward the passed size, shrinking by up to 16x per pass
+	auto				boxDownTo = [&](const Size & inTarget)	{
+		while (currentSize.width>inTarget.width || currentSize.height>inTarget.height)	{
+			Size			nextSize(max(inTarget.width, ceil(currentSize.width/16.)), max(inTarget.height, ceil(currentSize.height/16.)));
+			GLBufferRef		nextBuffer = createIntermediate(nextSize);
+			if (nextBuffer == nullptr)
+				return false;
+			filterCopierAt(FilterIndex_Box)->_drawInto(current, nextBuffer, Rect(0,0,nextSize.width,nextSize.height), false);
+			current = nextBuffer;
+			currentSize = nextSize;
+		}
+		return true;
+	};
+	
+	switch (_downscaleFilter)	{
+	case DownscaleFilter_Bilinear:
+		return false;
+	case DownscaleFilter_Mipmap:
+		{
+			//	copy the source into a pooled 2D texture (un-flipping it), generate its mipmaps, and draw it with trilinear filtering
+			Size			mipSize(max(1., round(currentSize.width)), max(1., round(currentSize.height)));
+			GLBufferRef		mipBuffer = createIntermediate(mipSize);
+			if (mipBuffer == nullptr)
+				return false;
+			//	the pool doesn't account for the memory used by mipmaps, so this texture is deleted instead of being returned to the pool
+			mipBuffer->preferDeletion = true;
+			_drawInto(a, mipBuffer, Rect(0,0,mipSize.width,mipSize.height), true);
+			_context->makeCurrentIfNotCurrent();
+			glBindTexture(mipBuffer->desc.target, mipBuffer->name);
+			GLERRLOG
+			//	trilinear filtering at this scale only reads the levels that bracket it- don't generate any smaller ones
+			double			mipScale = max(mipSize.width/dstSize.width, mipSize.height/dstSize.height);
+			GLint			maxLevel = max(1, static_cast<GLint>(ceil(log2(max(1.,mipScale)))));
+			glTexParameteri(mipBuffer->desc.target, GL_TEXTURE_MAX_LEVEL, maxLevel);
+			GLERRLOG
+			glGenerateMipmap(mipBuffer->desc.target);
+			GLERRLOG
+			glTexParameteri(mipBuffer->desc.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			GLERRLOG
+			glBindTexture(mipBuffer->desc.target, 0);
+			GLERRLOG
+			
+			_drawInto(mipBuffer, b, inDstRect, false);
+		}
+		return true;
+	case DownscaleFilter_Box:
+		//	shrink by up to 16x per pass, the last pass draws into the destination
+		if (!boxDownTo(Size(dstSize.width*16., dstSize.height*16.)))
+			return false;
+		finalCopier(FilterIndex_Box)->_drawInto(current, b, inDstRect, false);
+		return true;
+	case DownscaleFilter_Bicubic:
+	case DownscaleFilter_Lanczos:
+		{
+			//	the separable passes need too many taps past 8x- box-filter the source down to 4x the destination first
+			Size			preSize = currentSize;
+			if (preSize.width > dstSize.width*8.)
+				preSize.width = dstSize.width*4.;
+			if (preSize.height > dstSize.height*8.)
+				preSize.height = dstSize.height*4.;
+			if (!boxDownTo(preSize))
+				return false;
+			
+			//	filter horizontally into an intermediate that's as wide as the destination, then vertically into the destination
+			bool			lanczos = (_downscaleFilter==DownscaleFilter_Lanczos);
+			Size			horizontalSize(dstSize.width, max(1., round(currentSize.height)));
+			GLBufferRef		horizontalBuffer = createIntermediate(horizontalSize);
+			if (horizontalBuffer == nullptr)
+				return false;
+			filterCopierAt((lanczos) ? FilterIndex_LanczosH : FilterIndex_BicubicH)->_drawInto(current, horizontalBuffer, Rect(0,0,horizontalSize.width,horizontalSize.height), false);
+			finalCopier((lanczos) ? FilterIndex_LanczosV : FilterIndex_BicubicV)->_drawInto(horizontalBuffer, b, inDstRect, false);
+		}
+		return true;
+	}
+	return false;
+#else
+	//	ES 2 and legacy GL always use bilinear filtering
+	(void)a;
+	(void)b;
+	(void)inDstRect;
+	return false;
+#endif
+}
+
 
 
 
@@ -0,0 +1,129 @@
+#include "VVGL_AdaptiveQueueDepth.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+
+
+#if defined(VVGL_SDK_WIN)
+#ifdef max
+#undef max
+#endif	//	max
+#ifdef min
+#undef min
+#endif	//	min
+#endif	//	VVGL_SDK_WIN
+
+
+
+
+namespace VVGL
+{
+
+
+using namespace std;
+
+
+
+
+//	how heavily new measurements are weighted in the smoothed latency/interval
+static const double		AdaptiveQueueSmoothing = 0.1;
+//	the number of consecutive "calm" transfers required before the depth is reduced
+static const int		AdaptiveQueueCalmTransfers = 30;
+//	a transfer is "calm" if it would have completed in time with one less transfer in flight, with this much headroom
+static const double		AdaptiveQueueHeadroom = 0.8;
+
+
+void AdaptiveQueueDepth::_clampDepth()	{
+	_depth = max(_minDepth, min(_maxDepth, _depth));
+	//	the latency target wins over stall-free operation
+	if (_targetLatency > 0. && _interval > 0.)	{
+		int		latencyCap = static_cast<int>(floor(_targetLatency / _interval));
+		_depth = max(_minDepth, min(_depth, latencyCap));
+	}
+}
+void AdaptiveQueueDepth::setLimits(const int & inMin, const int & inMax)	{
+	_minDepth = max(1, inMin);
+	_maxDepth = max(_minDepth, inMax);
+	_clampDepth();
+}
+void AdaptiveQueueDepth::setTargetLatency(const double & inSeconds)	{
+	_targetLatency = max(0., inSeconds);
+	_clampDepth();
+}
+void AdaptiveQueueDepth::setDepth(const int & n)	{
+	_depth = n;
+	_calmCount = 0;
+	_clampDepth();
+}
+bool AdaptiveQueueDepth::isComplete(const int & inIndex) const	{
+	if (inIndex < 0 || inIndex >= static_cast<int>(_inFlight.size()))
+		return false;
+	return (_inFlight[inIndex].latency >= 0.);
+}
+void AdaptiveQueueDepth::noteSubmission()	{
+	auto		now = chrono::steady_clock::now();
+	if (_hasSubmission)	{
+		double		interval = chrono::duration<double>(now - _lastSubmission).count();
+		_interval = (_interval <= 0.) ? interval : _interval + (interval - _interval) * AdaptiveQueueSmoothing;
+	}
+	_lastSubmission = now;
+	_hasSubmission = true;
+	
+	Transfer		newTransfer;
+	newTransfer.submitted = now;
+	_inFlight.push_back(newTransfer);
+}
+void AdaptiveQueueDepth::noteCompletion(const int & inIndex)	{
+	if (inIndex < 0 || inIndex >= static_cast<int>(_inFlight.size()))
+		return;
+	Transfer		&transfer = _inFlight[inIndex];
+	if (transfer.latency >= 0.)
+		return;
+	transfer.latency = chrono::duration<double>(chrono::steady_clock::now() - transfer.submitted).count();
+	_latency = (_latency <= 0.) ? transfer.latency : _latency + (transfer.latency - _latency) * AdaptiveQueueSmoothing;
+}
+void AdaptiveQueueDepth::notePop(const bool & inStalled)	{
+	if (_inFlight.size() < 1)
+		return;
+	Transfer		transfer = _inFlight.front();
+	_inFlight.pop_front();
+	
+	//	if popping the transfer had to wait for it, the queue is too shallow: grow it immediately
+	if (inStalled || transfer.latency < 0.)	{
+		_calmCount = 0;
+		++_depth;
+		_clampDepth();
+		return;
+	}
+	
+	//	if the transfer would have completed before it was needed with one less transfer in flight, the queue may be deeper than it needs to be- shrink it after a run of such transfers
+	if (_depth > _minDepth && _interval > 0. && transfer.latency < AdaptiveQueueHeadroom * _interval * (_depth - 1))	{
+		++_calmCount;
+		if (_calmCount >= AdaptiveQueueCalmTransfers)	{
+			_calmCount = 0;
+			--_depth;
+		}
+	}
+	else
+		_calmCount = 0;
+	_clampDepth();
+}
+void AdaptiveQueueDepth::noteDrop()	{
+	if (_inFlight.size() > 0)
+		_inFlight.pop_front();
+}
+void AdaptiveQueueDepth::reset()	{
+	_inFlight.clear();
+	_hasSubmission = false;
+	_latency = 0.;
+	_interval = 0.;
+	_calmCount = 0;
+}
+
+
+
+
+
+}
@@ -0,0 +1,474 @@
+#include "VVGL_RowCopy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+
+
+
+#if defined(VVGL_SDK_WIN)
+#ifdef max
+#undef max
+#endif	//	max
+#ifdef min
+#undef min
+#endif	//	min
+#endif	//	VVGL_SDK_WIN
+
+
+
+
+namespace VVGL
+{
+
+
+using namespace std;
+
+
+
+
+//	copies smaller than this are done on the calling thread
+#define ROWCOPYPARALLELBYTES (2*1024*1024)
+//	copies that write more than this use non-temporal stores (the destination won't fit in the cache anyway, so don't evict everything else to make room for it)
+#define ROWCOPYSTREAMBYTES (8*1024*1024)
+//	the maximum number of worker threads in the row copy pool
+#define ROWCOPYMAXTHREADS 7
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define ROWCOPY_SSE2 1
+	#if defined(_MSC_VER)
+		#define ROWCOPY_TARGET_AVX2
+	#else
+		#define ROWCOPY_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define ROWCOPY_NEON 1
+#endif
+
+#if defined(ROWCOPY_SSE2)
+static bool CPUSupportsAVX2()	{
+	static const bool		returnMe = []()	{
+#if defined(_MSC_VER)
+		int			info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		//	the OS has to save the AVX registers (OSXSAVE + AVX, and XCR0 has the XMM and YMM bits set)
+		if ((info[2] & (1<<27))==0 || (info[2] & (1<<28))==0)
+			return false;
+		if ((_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return ((info[1] & (1<<5)) != 0);
+#else
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("avx2")) ? true : false;
+#endif
+	}();
+	return returnMe;
+}
+#endif
+
+
+//	each of these processes one row.  'inBytes' is the number of source bytes in the row.
+
+static void CopyRowScalar(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes)	{
+	memcpy(inDst, inSrc, inBytes);
+}
+static void SwapRBRowScalar(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes)	{
+	for (size_t i=0; i<inBytes; i+=4)	{
+		inDst[i+0] = inSrc[i+2];
+		inDst[i+1] = inSrc[i+1];
+		inDst[i+2] = inSrc[i+0];
+		inDst[i+3] = inSrc[i+3];
+	}
+}
+static inline uint8_t PackFloat(const float & n)	{
+	float		tmp = (n<0.f) ? 0.f : ((n>1.f) ? 1.f : n);
+	//	round half to even (the default rounding mode), like _mm_cvtps_epi32() and vcvtnq_u32_f32() in the SIMD paths
+	return static_cast<uint8_t>(nearbyint(tmp * 255.f));
+}
+static void FloatToUByteRowScalar(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const bool & inSwapRB)	{
+	const float		*rPtr = reinterpret_cast<const float*>(inSrc);
+	size_t			pixelCount = inBytes / 16;
+	for (size_t i=0; i<pixelCount; ++i)	{
+		inDst[0] = PackFloat(rPtr[(inSwapRB) ? 2 : 0]);
+		inDst[1] = PackFloat(rPtr[1]);
+		inDst[2] = PackFloat(rPtr[(inSwapRB) ? 0 : 2]);
+		inDst[3] = PackFloat(rPtr[3]);
+		rPtr += 4;
+		inDst += 4;
+	}
+}
+
+#if defined(ROWCOPY_SSE2)
+static void CopyRowStreamSSE2(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes)	{
+	//	non-temporal stores have to be aligned- copy the head normally
+	size_t			head = (16 - (reinterpret_cast<uintptr_t>(inDst) & 15)) & 15;
+	if (head > inBytes)
+		head = inBytes;
+	memcpy(inDst, inSrc, head);
+	size_t			i = head;
+	for (; i+64<=inBytes; i+=64)	{
+		__m128i		a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inSrc+i));
+		__m128i		b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inSrc+i+16));
+		__m128i		c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inSrc+i+32));
+		__m128i		d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inSrc+i+48));
+		_mm_stream_si128(reinterpret_cast<__m128i*>(inDst+i), a);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(inDst+i+16), b);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(inDst+i+32), c);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(inDst+i+48), d);
+	}
+	memcpy(inDst+i, inSrc+i, inBytes-i);
+}
+static inline __m128i SwapRBSSE2(const __m128i & n)	{
+	const __m128i		agMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+	const __m128i		lowMask = _mm_set1_epi32(0x000000FF);
+	__m128i				ag = _mm_and_si128(n, agMask);
+	__m128i				r = _mm_and_si128(_mm_srli_epi32(n, 16), lowMask);
+	__m128i				b = _mm_slli_epi32(_mm_and_si128(n, lowMask), 16);
+	return _mm_or_si128(ag, _mm_or_si128(r, b));
+}
+static void SwapRBRowSSE2(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const bool & inStream)	{
+	size_t			i = 0;
+	//	non-temporal stores have to be aligned- swap the head normally (the destination is always at least 4-byte aligned)
+	if (inStream)	{
+		size_t			head = (16 - (reinterpret_cast<uintptr_t>(inDst) & 15)) & 15;
+		i = (head > inBytes) ? inBytes : head;
+		SwapRBRowScalar(inSrc, inDst, i);
+	}
+	for (; i+16<=inBytes; i+=16)	{
+		__m128i		tmp = SwapRBSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inSrc+i)));
+		if (inStream)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(inDst+i), tmp);
+		else
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(inDst+i), tmp);
+	}
+	SwapRBRowScalar(inSrc+i, inDst+i, inBytes-i);
+}
+static void FloatToUByteRowSSE2(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const bool & inSwapRB)	{
+	const float		*rPtr = reinterpret_cast<const float*>(inSrc);
+	size_t			pixelCount = inBytes / 16;
+	const __m128	zero = _mm_setzero_ps();
+	const __m128	one = _mm_set1_ps(1.f);
+	const __m128	scale = _mm_set1_ps(255.f);
+	size_t			i = 0;
+	//	four pixels at a time: clamp, scale, round, and pack each float down to a byte
+	for (; i+4<=pixelCount; i+=4)	{
+		__m128i		px[4];
+		for (int j=0; j<4; ++j)	{
+			__m128		tmp = _mm_loadu_ps(rPtr + ((i+static_cast<size_t>(j))*4));
+			if (inSwapRB)
+				tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(3,0,1,2));
+			tmp = _mm_mul_ps(_mm_min_ps(_mm_max_ps(tmp, zero), one), scale);
+			px[j] = _mm_cvtps_epi32(tmp);
+		}
+		__m128i		lo = _mm_packs_epi32(px[0], px[1]);
+		__m128i		hi = _mm_packs_epi32(px[2], px[3]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(inDst + (i*4)), _mm_packus_epi16(lo, hi));
+	}
+	FloatToUByteRowScalar(inSrc + (i*16), inDst + (i*4), inBytes - (i*16), inSwapRB);
+}
+ROWCOPY_TARGET_AVX2 static void CopyRowStreamAVX2(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes)	{
+	size_t			head = (32 - (reinterpret_cast<uintptr_t>(inDst) & 31)) & 31;
+	if (head > inBytes)
+		head = inBytes;
+	memcpy(inDst, inSrc, head);
+	size_t			i = head;
+	for (; i+64<=inBytes; i+=64)	{
+		__m256i		a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inSrc+i));
+		__m256i		b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inSrc+i+32));
+		_mm256_stream_si256(reinterpret_cast<__m256i*>(inDst+i), a);
+		_mm256_stream_si256(reinterpret_cast<__m256i*>(inDst+i+32), b);
+	}
+	memcpy(inDst+i, inSrc+i, inBytes-i);
+}
+ROWCOPY_TARGET_AVX2 static void SwapRBRowAVX2(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const bool & inStream)	{
+	const __m256i		shuffle = _mm256_setr_epi8(2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15, 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15);
+	size_t			i = 0;
+	if (inStream)	{
+		size_t			head = (32 - (reinterpret_cast<uintptr_t>(inDst) & 31)) & 31;
+		i = (head > inBytes) ? inBytes : head;
+		SwapRBRowScalar(inSrc, inDst, i);
+	}
+	for (; i+32<=inBytes; i+=32)	{
+		__m256i		tmp = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(inSrc+i)), shuffle);
+		if (inStream)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(inDst+i), tmp);
+		else
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(inDst+i), tmp);
+	}
+	SwapRBRowScalar(inSrc+i, inDst+i, inBytes-i);
+}
+#endif	//	ROWCOPY_SSE2
+
+#if defined(ROWCOPY_NEON)
+static void SwapRBRowNEON(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes)	{
+	size_t			i = 0;
+	for (; i+64<=inBytes; i+=64)	{
+		uint8x16x4_t	px = vld4q_u8(inSrc+i);
+		uint8x16_t		tmp = px.val[0];
+		px.val[0] = px.val[2];
+		px.val[2] = tmp;
+		vst4q_u8(inDst+i, px);
+	}
+	SwapRBRowScalar(inSrc+i, inDst+i, inBytes-i);
+}
+static void FloatToUByteRowNEON(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const bool & inSwapRB)	{
+	const float		*rPtr = reinterpret_cast<const float*>(inSrc);
+	size_t			pixelCount = inBytes / 16;
+	const float32x4_t	zero = vdupq_n_f32(0.f);
+	const float32x4_t	one = vdupq_n_f32(1.f);
+	const float32x4_t	scale = vdupq_n_f32(255.f);
+	size_t			i = 0;
+	//	four pixels at a time: de-interleave the channels, clamp, scale, round, and narrow each channel down to a byte
+	for (; i+4<=pixelCount; i+=4)	{
+		float32x4x4_t	px = vld4q_f32(rPtr + (i*4));
+		uint8x8x4_t		out;
+		for (int j=0; j<4; ++j)	{
+			float32x4_t		tmp = vmulq_f32(vminq_f32(vmaxq_f32(px.val[j], zero), one), scale);
+			uint16x4_t		narrow = vmovn_u32(vcvtnq_u32_f32(tmp));
+			out.val[j] = vmovn_u16(vcombine_u16(narrow, narrow));
+		}
+		if (inSwapRB)	{
+			uint8x8_t		tmp = out.val[0];
+			out.val[0] = out.val[2];
+			out.val[2] = tmp;
+		}
+		//	only the low four lanes of each channel are valid
+		uint8_t			tmpBuffer[32];
+		vst4_u8(tmpBuffer, out);
+		memcpy(inDst + (i*4), tmpBuffer, 16);
+	}
+	FloatToUByteRowScalar(inSrc + (i*16), inDst + (i*4), inBytes - (i*16), inSwapRB);
+}
+#endif	//	ROWCOPY_NEON
+
+static void CopyRow(const uint8_t * inSrc, uint8_t * inDst, const size_t & inBytes, const RowCopyConversion & inConversion, const bool & inStream)	{
+	switch (inConversion)	{
+	case RowCopyConversion_None:
+#if defined(ROWCOPY_SSE2)
+		if (inStream)	{
+			if (CPUSupportsAVX2())
+				CopyRowStreamAVX2(inSrc, inDst, inBytes);
+			else
+				CopyRowStreamSSE2(inSrc, inDst, inBytes);
+			return;
+		}
+#endif
+		(void)inStream;
+		CopyRowScalar(inSrc, inDst, inBytes);
+		break;
+	case RowCopyConversion_SwapRB:
+#if defined(ROWCOPY_SSE2)
+		if (CPUSupportsAVX2())
+			SwapRBRowAVX2(inSrc, inDst, inBytes, inStream);
+		else
+			SwapRBRowSSE2(inSrc, inDst, inBytes, inStream);
+#elif defined(ROWCOPY_NEON)
+		SwapRBRowNEON(inSrc, inDst, inBytes);
+#else
+		SwapRBRowScalar(inSrc, inDst, inBytes);
+#endif
+		break;
+	case RowCopyConversion_FloatToUByte:
+	case RowCopyConversion_FloatToUByteSwapRB:
+#if defined(ROWCOPY_SSE2)
+		FloatToUByteRowSSE2(inSrc, inDst, inBytes, (inConversion==RowCopyConversion_FloatToUByteSwapRB));
+#elif defined(ROWCOPY_NEON)
+		FloatToUByteRowNEON(inSrc, inDst, inBytes, (inConversion==RowCopyConversion_FloatToUByteSwapRB));
+#else
+		FloatToUByteRowScalar(inSrc, inDst, inBytes, (inConversion==RowCopyConversion_FloatToUByteSwapRB));
+#endif
+		break;
+	}
+}
+
+
+//	a small pool of threads that split large copies up by rows.  the calling thread does its share 
+//	of the work too.  if the pool's busy with another copy, the caller just does the whole copy itself.
+class RowCopyThreadPool	{
+	private:
+		mutex						_submitLock;	//	held for the duration of a parallel copy
+		mutex						_lock;	//	used to serialize access to the vars below
+		condition_variable			_workCondition;
+		condition_variable			_doneCondition;
+		vector<thread>				_threads;
+		function<void(size_t)>		_task = nullptr;
+		size_t						_taskCount = 0;
+		size_t						_nextTask = 0;
+		size_t						_unfinishedTasks = 0;
+		uint64_t					_generation = 0;
+		
+		//	claims and runs tasks until there aren't any left
+		void _work(unique_lock<mutex> & inLock)	{
+			while (_nextTask < _taskCount)	{
+				size_t		taskIndex = _nextTask++;
+				inLock.unlock();
+				_task(taskIndex);
+				inLock.lock();
+				if (--_unfinishedTasks == 0)
+					_doneCondition.notify_all();
+			}
+		}
+	public:
+		RowCopyThreadPool()	{
+			unsigned int		hwThreads = thread::hardware_concurrency();
+			size_t				threadCount = (hwThreads>1) ? min(static_cast<size_t>(hwThreads-1), static_cast<size_t>(ROWCOPYMAXTHREADS)) : 0;
+			for (size_t i=0; i<threadCount; ++i)	{
+				_threads.emplace_back([this]()	{
+					uint64_t			lastGeneration = 0;
+					unique_lock<mutex>	tmpLock(_lock);
+					while (true)	{
+						_workCondition.wait(tmpLock, [&]()	{ return (_generation != lastGeneration); });
+						lastGeneration = _generation;
+						_work(tmpLock);
+					}
+				});
+				//	the pool is never freed (it lives for the duration of the process)
+				_threads.back().detach();
+			}
+		}
+		size_t threadCount() const { return _threads.size(); }
+		//	runs the passed task once for every index in [0, inCount), and returns when they've all finished
+		void parallelFor(const size_t & inCount, const function<void(size_t)> & inTask)	{
+			unique_lock<mutex>		submitLock(_submitLock, try_to_lock);
+			if (!submitLock.owns_lock() || _threads.size()==0)	{
+				for (size_t i=0; i<inCount; ++i)
+					inTask(i);
+				return;
+			}
+			unique_lock<mutex>		tmpLock(_lock);
+			_task = inTask;
+			_taskCount = inCount;
+			_nextTask = 0;
+			_unfinishedTasks = inCount;
+			++_generation;
+			_workCondition.notify_all();
+			_work(tmpLock);
+			_doneCondition.wait(tmpLock, [&]()	{ return (_unfinishedTasks == 0); });
+			_task = nullptr;
+		}
+};
+static RowCopyThreadPool & GetRowCopyThreadPool()	{
+	static RowCopyThreadPool		*returnMe = new RowCopyThreadPool;
+	return *returnMe;
+}
+
+
+void CopyRows(const void * inSrc, const size_t & inSrcBytesPerRow, void * inDst, const size_t & inDstBytesPerRow, const size_t & inRowBytes, const size_t & inRowCount, const RowCopyConversion & inConversion)	{
+	if (inSrc==nullptr || inDst==nullptr || inRowBytes==0 || inRowCount==0)
+		return;
+	
+	const uint8_t		*rPtr = static_cast<const uint8_t*>(inSrc);
+	uint8_t				*wPtr = static_cast<uint8_t*>(inDst);
+	size_t				totalBytes = inRowBytes * inRowCount;
+	size_t				dstRowBytes = (inConversion==RowCopyConversion_FloatToUByte || inConversion==RowCopyConversion_FloatToUByteSwapRB) ? inRowBytes/4 : inRowBytes;
+	bool				stream = (dstRowBytes * inRowCount >= ROWCOPYSTREAMBYTES);
+	
+	//	if the rows are contiguous and there's no conversion, this is one big copy- treat it as one long row that we can split up evenly
+	size_t				rowBytes = inRowBytes;
+	size_t				rowCount = inRowCount;
+	size_t				srcBPR = inSrcBytesPerRow;
+	size_t				dstBPR = inDstBytesPerRow;
+	if (inConversion==RowCopyConversion_None && srcBPR==inRowBytes && dstBPR==inRowBytes)	{
+		rowBytes = totalBytes;
+		rowCount = 1;
+	}
+	
+	//	figure out how many chunks to split the copy into
+	RowCopyThreadPool		&pool = GetRowCopyThreadPool();
+	size_t				chunkCount = 1;
+	if (totalBytes >= ROWCOPYPARALLELBYTES)
+		chunkCount = pool.threadCount() + 1;
+	
+	if (chunkCount <= 1)	{
+		for (size_t i=0; i<rowCount; ++i)
+			CopyRow(rPtr + (i*srcBPR), wPtr + (i*dstBPR), rowBytes, inConversion, stream);
+	}
+	//	a single long row is split into 64-byte-aligned spans...
+	else if (rowCount == 1)	{
+		size_t			spanBytes = ((rowBytes / chunkCount) + 63) & ~static_cast<size_t>(63);
+		pool.parallelFor(chunkCount, [&](size_t inChunk)	{
+			size_t			start = inChunk * spanBytes;
+			if (start >= rowBytes)
+				return;
+			size_t			length = min(spanBytes, rowBytes - start);
+			CopyRow(rPtr + start, wPtr + start, length, inConversion, stream);
+		});
+	}
+	//	...while everything else is split into bands of rows
+	else	{
+		size_t			rowsPerChunk = (rowCount + chunkCount - 1) / chunkCount;
+		pool.parallelFor(chunkCount, [&](size_t inChunk)	{
+			size_t			startRow = inChunk * rowsPerChunk;
+			size_t			endRow = min(startRow + rowsPerChunk, rowCount);
+			for (size_t i=startRow; i<endRow; ++i)
+				CopyRow(rPtr + (i*srcBPR), wPtr + (i*dstBPR), rowBytes, inConversion, stream);
+		});
+	}
+	
+#if defined(ROWCOPY_SSE2)
+	//	make the non-temporal stores visible before anybody else reads the destination
+	if (stream)
+		_mm_sfence();
+#endif
+}
+RowCopyConversion RowCopyConversionForDescriptors(const GLBuffer::Descriptor & inSrc, const GLBuffer::Descriptor & inDst)	{
+	auto		isEightBitColor = [](const GLBuffer::Descriptor & n)	{
+		return ((n.pixelFormat==GLBuffer::PF_RGBA || n.pixelFormat==GLBuffer::PF_BGRA) && (n.pixelType==GLBuffer::PT_UByte || n.pixelType==GLBuffer::PT_UInt_8888_Rev));
+	};
+	auto		isFloatColor = [](const GLBuffer::Descriptor & n)	{
+		return ((n.pixelFormat==GLBuffer::PF_RGBA || n.pixelFormat==GLBuffer::PF_BGRA) && n.pixelType==GLBuffer::PT_Float);
+	};
+	bool		swapRB = ((inSrc.pixelFormat==GLBuffer::PF_RGBA && inDst.pixelFormat==GLBuffer::PF_BGRA) || (inSrc.pixelFormat==GLBuffer::PF_BGRA && inDst.pixelFormat==GLBuffer::PF_RGBA));
+	
+	if (isEightBitColor(inSrc) && isEightBitColor(inDst))
+		return (swapRB) ? RowCopyConversion_SwapRB : RowCopyConversion_None;
+	if (isFloatColor(inSrc) && isEightBitColor(inDst))
+		return (swapRB) ? RowCopyConversion_FloatToUByteSwapRB : RowCopyConversion_FloatToUByte;
+	return RowCopyConversion_None;
+}
+void CopyBufferRows(const GLBufferRef & inSrc, const GLBufferRef & inDst)	{
+	if (inSrc==nullptr || inDst==nullptr || inSrc->cpuBackingPtr==nullptr || inDst->cpuBackingPtr==nullptr)
+		return;
+	
+	RowCopyConversion		conversion = RowCopyConversionForDescriptors(inSrc->desc, inDst->desc);
+	size_t			srcBPR = inSrc->desc.bytesPerRowForWidth(static_cast<uint32_t>(inSrc->size.width));
+	size_t			dstBPR = inDst->desc.bytesPerRowForWidth(static_cast<uint32_t>(inDst->size.width));
+	size_t			rowCount = static_cast<size_t>(min(inSrc->size.height, inDst->size.height));
+	size_t			rowBytes = 0;
+	//	conversions process whole pixels- the row length is the source's bytes for the narrower of the two buffers
+	if (conversion != RowCopyConversion_None)	{
+		size_t			pixelsPerRow = static_cast<size_t>(min(inSrc->size.width, inDst->size.width));
+		rowBytes = inSrc->desc.bytesPerRowForWidth(static_cast<uint32_t>(pixelsPerRow));
+	}
+	//	...while plain copies copy as many bytes as both rows have in common
+	else
+		rowBytes = min(srcBPR, dstBPR);
+	
+	CopyRows(inSrc->cpuBackingPtr, srcBPR, inDst->cpuBackingPtr, dstBPR, rowBytes, rowCount, conversion);
+}
+
+
+
+
+
+}
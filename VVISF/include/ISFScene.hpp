@@ -167,6 +167,15 @@ class VVISF_EXPORT ISFScene : public VVGL::GLScene	{
 		void renderToBuffer(const VVGL::GLBufferRef & inTargetBuffer, const VVGL::Size & inRenderSize, std::map<int32_t,VVGL::GLBufferRef> * outPassDict);
 		void renderToBuffer(const VVGL::GLBufferRef & inTargetBuffer, const VVGL::Size & inRenderSize);
 		void renderToBuffer(const VVGL::GLBufferRef & inTargetBuffer);
+		/*!
+		\brief Evaluates the dimensions of the loaded ISF's render passes at the passed size, and makes sure the buffer pool has enough free buffers to render a frame of that size without creating any GL resources.
+		\param inRenderSize The size of the frames you're going to render.
+		\param inPoolRef The buffer pool you're going to render with (if the scene has a private pool it's used instead- defaults to the global buffer pool).  When rendering into a buffer, the scene uses that buffer's pool- pass the target buffer's pool (or use reserveBuffersForRenderToBuffer()), or the reserved buffers won't be used.
+		Call this after loading a file or changing the render size to avoid creating textures mid-frame.  Buffers that are reserved but never used are released by the pool's housekeeping like any other free buffer.
+		*/
+		void reserveBuffersForRenderSize(const VVGL::Size & inRenderSize, const VVGL::GLBufferPoolRef & inPoolRef=nullptr);
+		//!	Same as reserveBuffersForRenderSize(), but reserves the buffers in the pool that renderToBuffer() will use for the passed target buffer (the scene's private pool, the target buffer's pool, or the global buffer pool, in that order).
+		void reserveBuffersForRenderToBuffer(const VVGL::GLBufferRef & inTargetBuffer, const VVGL::Size & inRenderSize);
 
 		virtual void setSize(const VVGL::Size & n);
 		VVGL::Size size() const { return _orthoSize; }
@@ -2,6 +2,8 @@
 #include "ISFDoc.hpp"
 #include "ISFPassTarget.hpp"
 
+#include <algorithm>
+
 
 
 
@@ -1382,6 +1384,84 @@ void ISFScene::_render(const GLBufferRef & inTargetBuffer, const VVGL::Size & in
 	GLERRLOG
 #endif
 	
+}
+void ISFScene::reserveBuffersForRenderSize(const VVGL::Size & inRenderSize, const GLBufferPoolRef & inPoolRef)	{
+	//	get the doc before we hold any other locks- bail if there's no doc
+	ISFDocRef			tmpDoc = doc();
+	if (tmpDoc == nullptr)
+		return;
+	
+	lock_guard<recursive_mutex> lock(_renderLock);
+	
+	//	use the same pool that _render() will use- _render() uses the target buffer's pool before the global pool, which the caller has to pass to us as 'inPoolRef'
+	GLBufferPoolRef		bp = _privatePool;
+	if (bp==nullptr)
+		bp = inPoolRef;
+	if (bp==nullptr)
+		bp = GetGlobalBufferPool();
+	if (bp==nullptr || _context==nullptr)
+		return;
+	
+	_context->makeCurrentIfNotCurrent();
+	
+	//	evaluate the dimensions of the pass targets at the passed render size (this also sizes the persistent buffers)
+	tmpDoc->evalBufferDimensionsWithRenderSize(inRenderSize);
+	
+	bool					shouldBeFloat = _alwaysRenderToFloat;
+	
+	//	every pass but the last renders into a new buffer, and they're all retained until the frame is done- count how many buffers of each type we need
+	struct BufferCount	{
+		bool			floatFlag;
+		VVGL::Size		size;
+		size_t			count;
+	};
+	vector<BufferCount>		bufferCounts;
+	vector<string>			passes = tmpDoc->renderPasses();
+	for (size_t i=0; i+1<passes.size(); ++i)	{
+		const string			&pass = passes[i];
+		ISFPassTargetRef		targetBuffer = nullptr;
+		if (pass.size()>0)	{
+			targetBuffer = tmpDoc->persistentPassTargetForKey(pass);
+			if (targetBuffer == nullptr)
+				targetBuffer = tmpDoc->tempPassTargetForKey(pass);
+		}
+		VVGL::Size			targetBufferSize = (targetBuffer==nullptr) ? inRenderSize : targetBuffer->targetSize();
+		bool				floatFlag = (shouldBeFloat || (targetBuffer!=nullptr && targetBuffer->floatFlag()));
+		
+		auto				countIt = find_if(bufferCounts.begin(), bufferCounts.end(), [&](const BufferCount & n) { return (n.floatFlag==floatFlag && n.size==targetBufferSize); });
+		if (countIt == bufferCounts.end())
+			bufferCounts.push_back({ floatFlag, targetBufferSize, 1 });
+		else
+			++countIt->count;
+	}
+	
+	//	create one buffer of each type the usual way (so it has the same descriptor as the buffers _render() will create), return it to the pool, and have the pool reserve the rest.  the pool's reserve() counts the buffer we returned, and moves them all to its shared free lists (so the render thread can use them if we're called from another thread).
+	for (const auto & bufferCount : bufferCounts)	{
+		GLBufferRef			tmpBuffer = nullptr;
+#if defined(VVGL_SDK_MAC)
+		if (_persistentToIOSurface)
+			tmpBuffer = (bufferCount.floatFlag) ? CreateRGBAFloatTexIOSurface(bufferCount.size, true, bp) : CreateRGBATexIOSurface(bufferCount.size, true, bp);
+		else
+#endif
+			tmpBuffer = (bufferCount.floatFlag) ? CreateRGBAFloatTex(bufferCount.size, true, bp) : CreateRGBATex(bufferCount.size, true, bp);
+		if (tmpBuffer == nullptr)
+			continue;
+		GLBuffer::Descriptor		tmpDesc = tmpBuffer->desc;
+		tmpBuffer = nullptr;
+		bp->reserve(tmpDesc, bufferCount.size, bufferCount.count, true);
+	}
+	
+	//	_render() also needs an FBO
+	GLBufferRef			tmpFBO = CreateFBO(true, bp);
+	if (tmpFBO != nullptr)	{
+		GLBuffer::Descriptor		tmpDesc = tmpFBO->desc;
+		VVGL::Size				tmpSize = tmpFBO->size;
+		tmpFBO = nullptr;
+		bp->reserve(tmpDesc, tmpSize, 1, true);
+	}
+}
+void ISFScene::reserveBuffersForRenderToBuffer(const GLBufferRef & inTargetBuffer, const VVGL::Size & inRenderSize)	{
+	reserveBuffersForRenderSize(inRenderSize, (inTargetBuffer==nullptr) ? nullptr : inTargetBuffer->parentBufferPool);
 }
 void ISFScene::setVertexShaderString(const string & n)	{
 	//cout << "*******************************\n";
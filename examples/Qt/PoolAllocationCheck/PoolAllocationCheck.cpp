@@ -0,0 +1,111 @@
+#include <QGuiApplication>
+#include <VVGL.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+
+
+
+
+//	every heap allocation made while 'countAllocations' is true is counted, so we can check that recycling a buffer doesn't allocate
+static std::atomic<bool>		countAllocations(false);
+static std::atomic<uint64_t>	allocationCount(0);
+
+void * operator new(std::size_t inSize)	{
+	if (countAllocations)
+		++allocationCount;
+	void		*returnMe = std::malloc((inSize==0) ? 1 : inSize);
+	if (returnMe == nullptr)
+		throw std::bad_alloc();
+	return returnMe;
+}
+void * operator new[](std::size_t inSize)	{
+	return operator new(inSize);
+}
+void operator delete(void * inPtr) noexcept	{
+	std::free(inPtr);
+}
+void operator delete[](void * inPtr) noexcept	{
+	std::free(inPtr);
+}
+void operator delete(void * inPtr, std::size_t) noexcept	{
+	std::free(inPtr);
+}
+void operator delete[](void * inPtr, std::size_t) noexcept	{
+	std::free(inPtr);
+}
+
+
+#if defined(Q_OS_WIN)
+extern "C"
+{
+	__declspec(dllexport) uint32_t NvOptimusEnablement = 0x00000001;
+	__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
+}
+#endif
+
+
+using namespace std;
+using namespace VVGL;
+
+
+//	the number of release->fetch cycles per buffer type, and how often the pool's housekeeping runs during them (once per "frame")
+static const int		CycleCount = 10000;
+static const int		CyclesPerHousekeeping = 4;
+
+
+//	fetches a buffer from the pool and releases it 'CycleCount' times (with periodic housekeeping), and returns the number of allocations made while doing so
+static uint64_t CountAllocationsInCycles(const GLBufferPoolRef & inPool, const function<GLBufferRef()> & inCreateBuffer)	{
+	//	warm up: the first cycles create the buffer, the thread's cache, the free list for the buffer's key, and the node pool that vends GLBufferRef control blocks
+	for (int i=0; i<CycleCount/10; ++i)	{
+		GLBufferRef		tmpBuffer = inCreateBuffer();
+		tmpBuffer = nullptr;
+		if ((i % CyclesPerHousekeeping) == 0)
+			inPool->housekeeping();
+	}
+
+	allocationCount = 0;
+	countAllocations = true;
+	for (int i=0; i<CycleCount; ++i)	{
+		GLBufferRef		tmpBuffer = inCreateBuffer();
+		tmpBuffer = nullptr;
+		if ((i % CyclesPerHousekeeping) == 0)
+			inPool->housekeeping();
+	}
+	countAllocations = false;
+	return allocationCount;
+}
+
+
+int main(int argc, char *argv[])
+{
+	QGuiApplication a(argc, argv);
+
+	//	make the shared context and the global buffer pool
+	GLContextRef		sharedContext = CreateNewGLContextRef(nullptr, nullptr, CreateDefaultSurfaceFormat());
+	if (sharedContext == nullptr)	{
+		cout << "ERR: shared context NULL" << endl;
+		return 1;
+	}
+	GLBufferPoolRef		bp = CreateGlobalBufferPool(sharedContext);
+	bp->context()->makeCurrentIfNotCurrent();
+
+	Size				bufferSize(1920, 1080);
+	uint64_t			texAllocations = CountAllocationsInCycles(bp, [&]()	{ return CreateRGBATex(bufferSize, true, bp); });
+	uint64_t			fboAllocations = CountAllocationsInCycles(bp, [&]()	{ return CreateFBO(true, bp); });
+	uint64_t			cpuAllocations = CountAllocationsInCycles(bp, [&]()	{ return CreateRGBACPUBuffer(bufferSize, bp); });
+
+	cout << "allocations in " << CycleCount << " release->fetch cycles (housekeeping every " << CyclesPerHousekeeping << " cycles):" << endl;
+	cout << "\ttextures: " << texAllocations << endl;
+	cout << "\tFBOs: " << fboAllocations << endl;
+	cout << "\tCPU buffers: " << cpuAllocations << endl;
+
+	bool				passed = (texAllocations==0 && fboAllocations==0 && cpuAllocations==0);
+	cout << ((passed) ? "PASSED" : "FAILED- recycling a buffer shouldn't allocate") << endl;
+
+	SetGlobalBufferPool(nullptr);
+	return (passed) ? 0 : 1;
+}
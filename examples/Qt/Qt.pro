@@ -9,10 +9,12 @@ SUBDIRS += \
 	VVISFTestApp \
 	TexUploadBenchmark \
 	TexDownloadBenchmark \
+	PoolAllocationCheck \
     ISFEditor
 
 TexUploadBenchmark.depends += VVGL
 TexDownloadBenchmark.depends += VVISF
+PoolAllocationCheck.depends += VVGL
 VVGLTestApp.depends += VVGL
 VVISF.depends += VVGL
 VVISFTestApp.depends += VVISF
@@ -5,6 +5,9 @@
 #include <QPainter>
 #include <QTimer>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 
 
@@ -31,6 +34,7 @@ TexUploadBenchmarkMainWindow::TexUploadBenchmarkMainWindow(QWidget *parent) :
 	//	we need to know when the user starts the test, or clicks 'checkImage'
 	connect(ui->checkButton, SIGNAL(clicked()), this, SLOT(checkImageClicked()));
 	connect(ui->startButton, SIGNAL(clicked()), this, SLOT(startTestClicked()));
+	connect(ui->poolTestButton, SIGNAL(clicked()), this, SLOT(poolTestClicked()));
 	
 	//	populate the texture type group
 	textureTypeGroup.addButton(ui->tt_2d, GLBuffer::Target_2D);
@@ -99,6 +103,53 @@ void TexUploadBenchmarkMainWindow::checkImageClicked()
 	
 	prepForWork();
 }
+void TexUploadBenchmarkMainWindow::poolTestClicked()
+{
+	cout << __PRETTY_FUNCTION__ << endl;
+	
+	GLBufferPoolRef		bp = GetGlobalBufferPool();
+	if (bp == nullptr)
+		return;
+	
+	//	every thread fetches and releases CPU buffers (which don't need a GL context) as fast as it can, while this thread runs housekeeping once per "frame"- this measures how well the pool's per-thread caches scale
+	const int			threadCount = max(2, static_cast<int>(thread::hardware_concurrency()));
+	const int			iterationsPerThread = 100000;
+	VVGL::Size			bufferSize(ui->widthField->value(), ui->heightField->value());
+	atomic<int>			runningThreads(threadCount);
+	vector<thread>		threads;
+	
+	//	prime the pool so the threads aren't timing the first allocations
+	{
+		vector<GLBufferRef>		primeBuffers;
+		for (int i=0; i<threadCount; ++i)
+			primeBuffers.push_back(CreateRGBACPUBuffer(bufferSize, bp));
+	}
+	bp->context()->makeCurrentIfNotCurrent();
+	bp->housekeeping();
+	
+	Timestamp			testStart;
+	for (int i=0; i<threadCount; ++i)	{
+		threads.emplace_back([&]()	{
+			for (int j=0; j<iterationsPerThread; ++j)	{
+				GLBufferRef		tmpBuffer = CreateRGBACPUBuffer(bufferSize, bp);
+			}
+			--runningThreads;
+		});
+	}
+	while (runningThreads > 0)	{
+		bp->housekeeping();
+		this_thread::sleep_for(chrono::milliseconds(16));
+	}
+	for (thread & tmpThread : threads)
+		tmpThread.join();
+	Timestamp			testEnd;
+	
+	double				totalSeconds = (testEnd - testStart).getTimeInSeconds();
+	double				totalIterations = double(threadCount) * double(iterationsPerThread);
+	string				tmpCPPString = FmtString("%d threads: %0.2fM fetch/release per sec", threadCount, totalIterations/totalSeconds/1000000.);
+	cout << "\t" << tmpCPPString << endl;
+	ui->resultsLabel->setText(QString::fromStdString(tmpCPPString));
+}
 
 
 /*	========================================	*/
@@ -24,6 +24,7 @@ public:
 public slots:
 	Q_SLOT void startTestClicked();
 	Q_SLOT void checkImageClicked();
+	Q_SLOT void poolTestClicked();
 	
 
 
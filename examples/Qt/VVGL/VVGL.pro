@@ -66,6 +66,8 @@ SOURCES += \
 	../../../VVGL/src/GLScene.cpp \
 	../../../VVGL/src/GLTexToCPUCopier.cpp \
 	../../../VVGL/src/GLTexToTexCopier.cpp \
+	../../../VVGL/src/VVGL_AdaptiveQueueDepth.cpp \
+	../../../VVGL/src/VVGL_RowCopy.cpp \
 	../../../VVGL/src/VVGL_Geom.cpp \
 	../../../VVGL/src/VVGL_StringUtils.cpp
 
@@ -85,6 +87,8 @@ HEADERS += \
 	../../../VVGL/include/GLScene.hpp \
 	../../../VVGL/include/GLTexToCPUCopier.hpp \
 	../../../VVGL/include/GLTexToTexCopier.hpp \
+	../../../VVGL/include/VVGL_AdaptiveQueueDepth.hpp \
+	../../../VVGL/include/VVGL_RowCopy.hpp \
 	../../../VVGL/include/VVGL_Base.hpp \
 	../../../VVGL/include/VVGL_Defines.hpp \
 	../../../VVGL/include/VVGL_Doxygen.hpp \